@@ -5,6 +5,8 @@
 #include "TVector.hh"
 #include "threadLocalGlobals.hpp"
 
+BEGIN_ENGINE_NAMESPACE
+
 class STOVector
 {
 private:
@@ -19,6 +21,8 @@ public:
         desc->preprocessTime = desc->startTime;
 #endif
         hasAborted = false;
+        // Every failure but a compare or an unknown operation comes from reaching past the elements.
+        AbortCause cause = AbortCause::outOfBounds;
         { // Scoped section.
             TransactionGuard t;
             for (size_t i = 0; i < desc->size; i++)
@@ -42,6 +46,52 @@ public:
                     }
                     vector[op->index] = op->val;
                     break;
+                case Operation::OpType::compareWrite:
+                case Operation::OpType::compareWriteOrAbort:
+                    if (vector.size() <= op->index)
+                    {
+                        hasAborted = true;
+                        break;
+                    }
+                    // Report the value found, and only write over the expected one.
+                    op->ret = vector[op->index];
+                    if (op->ret == op->expected)
+                    {
+                        vector[op->index] = op->val;
+                    }
+                    else if (op->type == Operation::OpType::compareWriteOrAbort)
+                    {
+                        cause = AbortCause::compareFailed;
+                        hasAborted = true;
+                    }
+                    break;
+                case Operation::OpType::fetchAdd:
+                case Operation::OpType::fetchMin:
+                case Operation::OpType::fetchMax:
+                case Operation::OpType::fetchXor:
+                    // Updates leave elements without a value alone.
+                    // They abort rather than store UNSET, which would read as an unset element that size still counts.
+                    if (op->val == UNSET)
+                    {
+                        cause = AbortCause::invalid;
+                        hasAborted = true;
+                    }
+                    else if (op->index < vector.size())
+                    {
+                        VAL current = vector[op->index];
+                        if (current != UNSET)
+                        {
+                            current = Operation::applyDelta(op->type, current, op->val);
+                            if (current == UNSET)
+                            {
+                                cause = AbortCause::invalid;
+                                hasAborted = true;
+                                break;
+                            }
+                            vector[op->index] = current;
+                        }
+                    }
+                    break;
                 case Operation::OpType::pushBack:
                     vector.push_back(op->val);
                     break;
@@ -50,7 +100,8 @@ public:
                     vector.pop_back();
                     break;
                 case Operation::OpType::size:
-                    op->ret = vector.size();
+                    // Size results go in index, same as in the other vectors.
+                    op->index = op->ret = vector.size();
                     if (op->ret == UNSET)
                     {
                         hasAborted = true;
@@ -62,6 +113,7 @@ public:
                     // Do nothing for now.
                     break;
                 default:
+                    cause = AbortCause::invalid;
                     hasAborted = true;
                     break;
                 }
@@ -78,7 +130,7 @@ public:
         }
         else
         {
-            desc->status.store(Desc::TxStatus::aborted);
+            desc->abort(cause);
         }
 #ifdef METRICS
         desc->endTime = std::chrono::high_resolution_clock::now();
@@ -93,4 +145,6 @@ public:
     }
 };
 
+END_ENGINE_NAMESPACE
+
 #endif
\ No newline at end of file
@@ -1,86 +1,139 @@
 #include "allocator.hpp"
+#include "epoch.hpp"
+
+BEGIN_ENGINE_NAMESPACE
 
 // Initialize per-thread allocators.
-void threadAllocatorInit([[maybe_unused]] int threadNum)
+void threadAllocatorInit()
 {
+	[[maybe_unused]] size_t slot = ThreadRegistry::attach();
 #ifdef SEGMENTVEC
-	Allocator<Page<VAL, SGMT_SIZE>>::threadInit(threadNum);
-	Allocator<Page<size_t, 1>>::threadInit(threadNum);
-	Allocator<std::map<size_t, Page<VAL, SGMT_SIZE> *, ORDER, MyPageAllocator>>::threadInit(threadNum);
+	Allocator<Page<VAL, SGMT_SIZE>>::threadInit(slot);
+	Allocator<Page<size_t, 2>>::threadInit(slot);
+	Allocator<PageMap>::threadInit(slot);
 #endif
 #ifdef COMPACTVEC
-	Allocator<CompactElement>::threadInit(threadNum);
+	Allocator<CompactElement>::threadInit(slot);
 #endif
 #if defined(SEGMENTVEC) || defined(COMPACTVEC) || defined(BOOSTEDVEC)
-	Allocator<RWOperation>::threadInit(threadNum);
-	Allocator<RWSet>::threadInit(threadNum);
+	Allocator<RWOperation>::threadInit(slot);
+	Allocator<RWSet>::threadInit(slot);
 #endif
 	return;
 }
 
-void allocatorInit()
+// Release per-thread allocators, so the objects they cache are not lost when the thread exits.
+void threadAllocatorFinish()
 {
-#ifdef ALLOC_COUNT
-	printf("Initializing the memory allocators.\n");
-	printf("sizeof(Operation *)=%lu\n", sizeof(Operation *));
+	// Reclaiming retired sets and pages maps hands them back to the object allocators, so do it before they are flushed.
+	Epoch::threadFinish();
+#ifdef SEGMENTVEC
+	Allocator<Page<VAL, SGMT_SIZE>>::threadFinish();
+	Allocator<Page<size_t, 2>>::threadFinish();
+	Allocator<PageMap>::threadFinish();
 #endif
-	MemAllocator<Operation *>::init((NUM_TRANSACTIONS * TRANSACTION_SIZE * THREAD_COUNT) + 1);
-// NOTE: Other MemAllocators are implicitly initialized.
-// Would be better to initialize them in advance for performance.
-// It's not a big deal if we pre-fill the vector first.
-#ifdef ALLOC_COUNT
-	printf("Finished initializing the memory allocators.\n\n");
+#ifdef COMPACTVEC
+	Allocator<CompactElement>::threadFinish();
 #endif
+#if defined(SEGMENTVEC) || defined(COMPACTVEC) || defined(BOOSTEDVEC)
+	Allocator<RWOperation>::threadFinish();
+	Allocator<RWSet>::threadFinish();
+#endif
+	Region::threadFinish();
+	ThreadRegistry::detach();
+	return;
+}
+
+#ifndef FIRST_TOUCH
+// Construct the preallocated objects of every allocator.
+static void prefaultAllocators()
+{
+#ifdef SEGMENTVEC
+	Allocator<Page<VAL, SGMT_SIZE>>::prefault();
+	Allocator<Page<size_t, 2>>::prefault();
+	Allocator<PageMap>::prefault();
+#endif
+#ifdef COMPACTVEC
+	Allocator<CompactElement>::prefault();
+#endif
+#if defined(SEGMENTVEC) || defined(COMPACTVEC) || defined(BOOSTEDVEC)
+	Allocator<RWOperation>::prefault();
+	Allocator<RWSet>::prefault();
+#endif
+	return;
+}
+#endif
+
+void allocatorInit([[maybe_unused]] size_t threads, [[maybe_unused]] size_t transactions, [[maybe_unused]] size_t transactionSize)
+{
+// NOTE: MemAllocators need no initialization. Their regions take chunks from a shared pool as they grow.
+// The object allocators grow on demand. These sizes only reserve shares for a known workload, so allocation stays out of its timed section.
+// Each allocator reserves a share for the first worker slots now. A thread attaching with any later slot reserves its own.
+	if (transactions == 0)
+	{
+		return;
+	}
 
 #ifdef SEGMENTVEC
 // Preallocate the pages.
 #ifdef ALLOC_COUNT
 	printf("sizeof(Page<VAL, SGMT_SIZE>)=%lu\n", sizeof(Page<VAL, SGMT_SIZE>));
 #endif
-	Allocator<Page<VAL, SGMT_SIZE>>::init((size_t)(NUM_TRANSACTIONS * 1.064) * TRANSACTION_SIZE);
+	Allocator<Page<VAL, SGMT_SIZE>>::init((size_t)(transactions * 1.064) * transactionSize, threads);
 // Preallocate the size pages.
 #ifdef ALLOC_COUNT
-	printf("sizeof(Page<size_t, 1>)=%lu\n", sizeof(Page<size_t, 1>));
+	printf("sizeof(Page<size_t, 2>)=%lu\n", sizeof(Page<size_t, 2>));
 #endif
-	Allocator<Page<size_t, 1>>::init((NUM_TRANSACTIONS + 1) * TRANSACTION_SIZE);
+	Allocator<Page<size_t, 2>>::init(transactions + 1, threads);
 // Preallocate page maps.
 #ifdef ALLOC_COUNT
-	printf("sizeof(std::map<size_t, Page<VAL, SGMT_SIZE> *, ORDER, MyPageAllocator>)=%lu\n", sizeof(std::map<size_t, Page<VAL, SGMT_SIZE> *, ORDER, MyPageAllocator>));
+	printf("sizeof(PageMap)=%lu\n", sizeof(PageMap));
 #endif
-	Allocator<std::map<size_t, Page<VAL, SGMT_SIZE> *, ORDER, MyPageAllocator>>::init((NUM_TRANSACTIONS + 1) * TRANSACTION_SIZE);
+	Allocator<PageMap>::init(transactions + 1, threads);
 #endif
 #ifdef COMPACTVEC
 // Preallocate compact elements.
 #ifdef ALLOC_COUNT
 	printf("sizeof(CompactElement)=%lu\n", sizeof(CompactElement));
 #endif
-	Allocator<CompactElement>::init((NUM_TRANSACTIONS + 1) * TRANSACTION_SIZE);
+	Allocator<CompactElement>::init(transactions + 1, threads);
 #endif
 #if defined(SEGMENTVEC) || defined(COMPACTVEC) || defined(BOOSTEDVEC)
 // Preallocate the RWOperation elements.
 #ifdef ALLOC_COUNT
 	printf("sizeof(RWOperation)=%lu\n", sizeof(RWOperation));
 #endif
-	Allocator<RWOperation>::init(2 * NUM_TRANSACTIONS * TRANSACTION_SIZE * THREAD_COUNT);
+	Allocator<RWOperation>::init(2 * transactions * transactionSize, threads);
 // Preallocate the RWSet elements.
 #ifdef ALLOC_COUNT
 	printf("sizeof(RWSet)=%lu\n", sizeof(RWSet));
 #endif
-	Allocator<RWSet>::init((1 + NUM_TRANSACTIONS) * THREAD_COUNT);
+	Allocator<RWSet>::init(transactions + 1, threads);
+#endif
+
+#ifndef FIRST_TOUCH
+	// Construct the objects on one thread per reserved share. This also faults in the slabs.
+	// With FIRST_TOUCH, each worker thread does this for its own share in threadAllocatorInit instead.
+	std::vector<std::thread> builders;
+	for (size_t i = 0; i < threads; i++)
+	{
+		builders.push_back(std::thread(prefaultAllocators));
+	}
+	for (std::thread &builder : builders)
+	{
+		builder.join();
+	}
 #endif
 	return;
 }
 
 void allocatorReport()
 {
-	// Report memory allocator usage.
-	MemAllocator<Operation *>::report();
-
 // Report object allocator usage.
 #ifdef SEGMENTVEC
 	Allocator<Page<VAL, SGMT_SIZE>>::report();
-	Allocator<Page<size_t, 1>>::report();
-	Allocator<std::map<size_t, Page<VAL, SGMT_SIZE> *, ORDER, MyPageAllocator>>::report();
+	Allocator<Page<size_t, 2>>::report();
+	Allocator<PageMap>::report();
 #endif
 #ifdef COMPACTVEC
 // Preallocate compact elements.
@@ -95,3 +148,24 @@ void allocatorReport()
 #endif
 	return;
 }
+
+std::vector<MemoryStats> memoryStats()
+{
+	std::vector<MemoryStats> stats;
+#ifdef SEGMENTVEC
+	stats.push_back(Allocator<Page<VAL, SGMT_SIZE>>::stats("Page"));
+	stats.push_back(Allocator<Page<size_t, 2>>::stats("Size page"));
+	stats.push_back(Allocator<PageMap>::stats("Page map"));
+#endif
+#ifdef COMPACTVEC
+	stats.push_back(Allocator<CompactElement>::stats("CompactElement"));
+#endif
+#if defined(SEGMENTVEC) || defined(COMPACTVEC) || defined(BOOSTEDVEC)
+	stats.push_back(Allocator<RWOperation>::stats("RWOperation"));
+	stats.push_back(Allocator<RWSet>::stats("RWSet"));
+#endif
+	stats.push_back(Region::stats());
+	return stats;
+}
+
+END_ENGINE_NAMESPACE
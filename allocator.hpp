@@ -3,124 +3,451 @@
 
 #include <assert.h>
 #include <atomic>
+#include <cstdint>
+#include <malloc.h>
 #include <mutex>
+#include <sys/mman.h>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include "define.hpp"
+#include "memoryStats.hpp"
+#include "taggedStack.hpp"
+#include "threadRegistry.hpp"
 
 // Contains classes preallocated by the Allocator.
 #include "deltaPage.hpp"
 #include "rwSet.hpp"
 
+BEGIN_ENGINE_NAMESPACE
+
 template <class T, size_t S>
 class Page;
 
 class RWOperation;
 
+// Hands out objects of a single type.
+// Each thread caches objects in magazines, so most allocations and deallocations never touch shared memory.
+// Full magazines move between threads through a shared depot.
+// New objects come from the slabs reserved for each thread, and then from slabs carved on demand.
+// Each ThreadRegistry slot gets a share of its own, so the thread holding it can fault in (and keep local) the objects it uses.
 template <typename DataType>
 class Allocator
 {
+private:
+  // A fixed-size batch of free objects.
+  struct Magazine
+  {
+    DataType *objects[MAGAZINE_SIZE];
+    size_t count = 0;
+    // Links magazines in the depot.
+    std::atomic<Magazine *> next;
+  };
+
+  // The magazine allocations come from and deallocations go to.
+  thread_local static Magazine *loaded;
+  // Always either empty or full, so swapping it in after loaded runs out (or fills up) is always useful.
+  thread_local static Magazine *spare;
+  // The number of magazines the next slab will hold. Doubles each time, up to MAX_SLAB_MAGAZINES.
+  thread_local static size_t slabMagazines;
+  // Full magazines shared between all threads.
+  static TaggedStack<Magazine> fullDepot;
+  // Empty magazines shared between all threads. Magazines are never freed.
+  static TaggedStack<Magazine> emptyDepot;
+  // The objects reserved for one ThreadRegistry slot. They are constructed a magazine at a time.
+  // A slot keeps its share when a thread detaches, so the next thread to attach with it picks up what is left.
+  struct Share
+  {
+    size_t slot;
+    DataType *objects;
+    // The next magazine to construct.
+    std::atomic<size_t> next;
+    // Links every share. Shares are never freed.
+    Share *link;
+  };
+
+  // Every share reserved so far, one per slot that ever attached.
+  static std::atomic<Share *> shares;
+  // The number of magazines in each share. Set by init.
+  static size_t shareMagazines;
+  // The share of the calling thread's slot, or NULL for a thread without one.
+  thread_local static Share *share;
+  // Full magazines this thread built from its own share, linked through their next pointers.
+  thread_local static Magazine *owned;
+
+  // Statistics. These only change when whole magazines move, or once per MAGAZINE_SIZE retired objects.
+  // Bytes taken from the system for objects.
+  static std::atomic<size_t> reservedBytes;
+  // Objects held by threads, whether in use or cached in their magazines.
+  static std::atomic<size_t> heldObjects;
+  static std::atomic<size_t> highWaterObjects;
+  // Slabs carved after the reserved shares ran out.
+  static std::atomic<size_t> fallbackSlabs;
+  static std::atomic<size_t> retiredObjects;
+  // Retired objects not yet added to retiredObjects.
+  thread_local static size_t pendingRetired;
+
+  // Count objects moving to or from the calling thread.
+  static void hold(size_t objects)
+  {
+    raiseHighWater(highWaterObjects, heldObjects.fetch_add(objects, std::memory_order_relaxed) + objects);
+    return;
+  }
+  static void release(size_t objects)
+  {
+    heldObjects.fetch_sub(objects, std::memory_order_relaxed);
+    return;
+  }
+
+  // Get an empty magazine.
+  static Magazine *empty()
+  {
+    Magazine *magazine = emptyDepot.pop();
+    if (magazine == NULL)
+    {
+      magazine = new Magazine();
+    }
+    return magazine;
+  }
+  // Map untouched memory for a slab, so whichever thread constructs the objects also faults in their pages.
+  static void *map(size_t bytes)
+  {
+#ifdef HUGE_PAGES
+    // Transparent huge pages only back aligned ranges, so over-map and start at the first huge page boundary.
+    // The unused ends only cost address space.
+    const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+    bytes = (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    char *raw = (char *)mmap(NULL, bytes + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(raw != MAP_FAILED);
+    char *slab = (char *)(((uintptr_t)raw + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+    // Only a hint. Without transparent huge pages, the slab is still contiguous.
+    madvise(slab, bytes, MADV_HUGEPAGE);
+    return slab;
+#else
+    void *slab = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(slab != MAP_FAILED);
+    return slab;
+#endif
+  }
+  // Get the share of a slot, reserving it if no thread held the slot before.
+  // Only the thread holding a slot reserves its share, so no slot gets two.
+  static Share *shareFor(size_t slot)
+  {
+    for (Share *current = shares.load(); current != NULL; current = current->link)
+    {
+      if (current->slot == slot)
+      {
+        return current;
+      }
+    }
+    Share *created = new Share();
+    created->slot = slot;
+    created->objects = (DataType *)map(sizeof(DataType) * MAGAZINE_SIZE * shareMagazines);
+    created->next.store(0);
+    reservedBytes.fetch_add(sizeof(DataType) * MAGAZINE_SIZE * shareMagazines, std::memory_order_relaxed);
+    Share *head = shares.load();
+    do
+    {
+      created->link = head;
+    } while (!shares.compare_exchange_weak(head, created));
+    return created;
+  }
+  // Construct the next magazine of a share.
+  // Returns NULL once the share is used up.
+  static Magazine *claim(Share *from)
+  {
+    // Check first, so the counter stops growing once the share runs out.
+    if (from->next.load() >= shareMagazines)
+    {
+      return NULL;
+    }
+    size_t index = from->next.fetch_add(1);
+    if (index >= shareMagazines)
+    {
+      return NULL;
+    }
+    Magazine *magazine = empty();
+    DataType *objects = from->objects + index * MAGAZINE_SIZE;
+    for (size_t i = 0; i < MAGAZINE_SIZE; i++)
+    {
+      magazine->objects[i] = ::new (&objects[i]) DataType();
+    }
+    magazine->count = MAGAZINE_SIZE;
+    return magazine;
+  }
+  // Construct the next magazine left in any share.
+  // The calling thread's own share goes first, so other threads' shares are only taken once it runs out.
+  static Magazine *claimAny()
+  {
+    if (share != NULL)
+    {
+      Magazine *magazine = claim(share);
+      if (magazine != NULL)
+      {
+        return magazine;
+      }
+    }
+    for (Share *other = shares.load(); other != NULL; other = other->link)
+    {
+      Magazine *magazine = claim(other);
+      if (magazine != NULL)
+      {
+        return magazine;
+      }
+    }
+    return NULL;
+  }
+  // Allocate a slab of new objects and split it into full magazines.
+  // Returns one of them. The rest go to the depot.
+  static Magazine *carve()
+  {
+    // Use up the reserved shares before allocating more.
+    Magazine *reservedMagazine = claimAny();
+    if (reservedMagazine != NULL)
+    {
+      return reservedMagazine;
+    }
+    size_t magazines = slabMagazines;
+    if (slabMagazines < MAX_SLAB_MAGAZINES)
+    {
+      slabMagazines *= 2;
+    }
+    DataType *slab = (DataType *)memalign(alignof(DataType), sizeof(DataType) * MAGAZINE_SIZE * magazines);
+    assert(slab != NULL);
+    reservedBytes.fetch_add(sizeof(DataType) * MAGAZINE_SIZE * magazines, std::memory_order_relaxed);
+    fallbackSlabs.fetch_add(1, std::memory_order_relaxed);
+    Magazine *first = NULL;
+    for (size_t i = 0; i < magazines; i++)
+    {
+      Magazine *magazine = empty();
+      for (size_t j = 0; j < MAGAZINE_SIZE; j++)
+      {
+        magazine->objects[j] = ::new (&slab[i * MAGAZINE_SIZE + j]) DataType();
+      }
+      magazine->count = MAGAZINE_SIZE;
+      if (first == NULL)
+      {
+        first = magazine;
+      }
+      else
+      {
+        fullDepot.push(magazine);
+      }
+    }
+    return first;
+  }
+  // Make loaded non-empty. Only called once it runs out.
+  static void reload()
+  {
+    if (spare != NULL && spare->count != 0)
+    {
+      std::swap(loaded, spare);
+      return;
+    }
+    // Both are empty, so trade one for a full magazine.
+    if (spare == NULL)
+    {
+      spare = loaded;
+    }
+    else if (loaded != NULL)
+    {
+      emptyDepot.push(loaded);
+    }
+    // Prefer the magazines this thread built itself, since their memory is local to it.
+    if (owned != NULL)
+    {
+      loaded = owned;
+      owned = owned->next.load(std::memory_order_relaxed);
+      return;
+    }
+    loaded = fullDepot.pop();
+    if (loaded == NULL)
+    {
+      loaded = carve();
+    }
+    hold(loaded->count);
+    return;
+  }
+  // Hand a magazine to the depot matching how full it is.
+  static void flush(Magazine *magazine)
+  {
+    if (magazine == NULL)
+    {
+      return;
+    }
+    if (magazine->count == 0)
+    {
+      emptyDepot.push(magazine);
+    }
+    else
+    {
+      release(magazine->count);
+      fullDepot.push(magazine);
+    }
+    return;
+  }
+  // Make loaded non-full. Only called once it fills up.
+  static void unload()
+  {
+    if (loaded == NULL)
+    {
+      loaded = empty();
+      return;
+    }
+    if (spare != NULL && spare->count == 0)
+    {
+      std::swap(loaded, spare);
+      return;
+    }
+    // Both are full, so share one with the other threads.
+    if (spare != NULL)
+    {
+      release(spare->count);
+      fullDepot.push(spare);
+    }
+    spare = loaded;
+    loaded = empty();
+    return;
+  }
+
 public:
-  static bool isInit;
-  // Lock used to improve memory allocation rate.
-  //static std::mutex allocLock;
-  thread_local static size_t threadNum;
-  // The pool of objects.
-  static std::vector<std::vector<DataType *> *> pool;
 #ifdef ALLOC_COUNT
   // A counter used to keep track of allocations. Use this to tune allocation sizes.
   static std::atomic<size_t> count;
 #endif
 
-  // Initialize the allocator.
-  static void init(size_t poolSize = 0)
+  // Initialize the allocator by setting how many objects each ThreadRegistry slot reserves, so the objects a thread uses most are densely packed.
+  // Shares for the first slots can be reserved now. Any other slot reserves its own when a thread first initializes with it.
+  // Nothing is constructed or faulted in yet. Either call prefault, or let threads construct magazines as they run out.
+  // objects:   How many objects to reserve for each slot. Only a warm-up hint, since the allocator grows on demand.
+  // threads:   How many slots, counting from 0, to reserve shares for now.
+  static void init(size_t objects = 0, size_t threads = 0)
   {
-    // Only initialize the pool once.
-    if (isInit)
+    if (objects == 0 || shareMagazines != 0)
     {
-      printf("Attempted to initialize a pool that has already been initialized.\n");
       return;
     }
-    // Initialize an empty pool for each thread.
-    for (size_t i = 0; i < THREAD_COUNT; i++)
+    shareMagazines = (objects + MAGAZINE_SIZE - 1) / MAGAZINE_SIZE;
+    for (size_t slot = 0; slot < threads; slot++)
     {
-      std::vector<DataType *> *threadPool = new std::vector<DataType *>();
-      threadPool->reserve(poolSize);
-
-      // Initialize the pool of objects.
-      for (size_t j = 0; j < poolSize; j++)
+      shareFor(slot);
+    }
+    return;
+  }
+  // Construct every remaining object in the shares reserved so far, faulting in their memory.
+  // Any number of threads can call this at once to split the work.
+  static void prefault()
+  {
+    Magazine *magazine = NULL;
+    while ((magazine = claimAny()) != NULL)
+    {
+      fullDepot.push(magazine);
+    }
+    return;
+  }
+  // Initialize the thread-local allocator cache.
+  // Optional. Threads otherwise fill their cache on their first allocation.
+  // slot:   The ThreadRegistry slot of the calling thread, or ThreadRegistry::NONE.
+  //         A thread with a slot takes over the slot's share, reserving it if no thread held the slot before.
+  //         With FIRST_TOUCH, it also builds what is left of the share here.
+  static void threadInit(size_t slot = ThreadRegistry::NONE)
+  {
+    if (slot != ThreadRegistry::NONE && shareMagazines != 0)
+    {
+      share = shareFor(slot);
+    }
+#ifdef FIRST_TOUCH
+    if (share != NULL)
+    {
+      // Faulting the share in from this thread places its memory on this thread's NUMA node.
+      Magazine *magazine = NULL;
+      while ((magazine = claim(share)) != NULL)
       {
-        DataType *object = new DataType();
-        if (object == NULL)
-        {
-          printf("Something bad happened!\n");
-        }
-        threadPool->push_back(object);
+        hold(magazine->count);
+        magazine->next.store(owned, std::memory_order_relaxed);
+        owned = magazine;
       }
-      pool.push_back(threadPool);
     }
-    // Mark as initilized, so it never gets initialized again.
-    isInit = true;
+#endif
+    if (loaded == NULL)
+    {
+      reload();
+    }
     return;
   }
-  // Initialize the thread-local allocator pool.
-  static void threadInit(int threadNum = -1)
+  // Hand every object cached by the calling thread back to the depots, so other threads can use them.
+  // Call this before a thread exits. The thread can still allocate afterwards, and just starts with an empty cache.
+  static void threadFinish()
   {
-    if ((size_t)threadNum > pool.size() || threadNum < 0)
+    flush(loaded);
+    flush(spare);
+    while (owned != NULL)
     {
-      printf("Requested pool %d when %lu pools are allocated.\n", threadNum, pool.size());
-      return;
+      Magazine *next = owned->next.load(std::memory_order_relaxed);
+      flush(owned);
+      owned = next;
     }
-    // Give the thread a threadNum.
-    // Multiple threads can have the same number, but access to the allocator shared between those threads is not thread safe.
-    // The intention is that new threads can reuse the pool from old threads.
-    Allocator<DataType>::threadNum = threadNum;
+    retiredObjects.fetch_add(pendingRetired, std::memory_order_relaxed);
+    pendingRetired = 0;
+    loaded = NULL;
+    spare = NULL;
+    share = NULL;
+    slabMagazines = 1;
     return;
   }
-  // Get a delta page with the appropriate size.
+  // Get an object from the allocator.
   static DataType *alloc()
   {
-    //return new DataType();
 #ifdef ALLOC_COUNT
     // Increment counter.
     Allocator<DataType>::count.fetch_add(1);
 #endif
-
-    if (threadNum == SIZE_MAX)
-    {
-      printf("A thread that did not initialize with the allocator has requested an object.\n");
-      return NULL;
-    }
-
-    DataType *object = NULL;
-    if (pool[threadNum]->size() > 0)
-    {
-      object = pool[threadNum]->back();
-      pool[threadNum]->pop_back();
-    }
-    else
-    {
-      printf("Pool for thread %lu ran out of elements of size %lu.\n", threadNum, sizeof(DataType));
-      object = new DataType();
-    }
-    if (object == NULL)
+    if (loaded == NULL || loaded->count == 0)
     {
-      printf("Something bad happened!\n");
+      reload();
     }
-    return object;
+    return loaded->objects[--loaded->count];
   }
-  // Return a page that is no longer needed into the pool.
+  // Return an object that is no longer needed.
+  // Any thread can return any object, regardless of which thread allocated it.
   static void dealloc(DataType *object)
   {
     // Reset the object.
+    // Destroy it first, so anything it owns (such as an overflowing read list) is released.
+    object->~DataType();
     ::new (object) DataType();
-    // Return the object to the pool.
-    pool[threadNum]->push_back(object);
+    if (loaded == NULL || loaded->count == MAGAZINE_SIZE)
+    {
+      unload();
+    }
+    loaded->objects[loaded->count++] = object;
     return;
-
-    // Old: Deallocate the object.
-    //delete object;
+  }
+  // Count objects that are no longer needed but stay reachable, so they can never be deallocated.
+  static void retire(size_t objects = 1)
+  {
+    pendingRetired += objects;
+    if (pendingRetired >= MAGAZINE_SIZE)
+    {
+      retiredObjects.fetch_add(pendingRetired, std::memory_order_relaxed);
+      pendingRetired = 0;
+    }
+    return;
+  }
+  // Get a snapshot of this pool's memory use.
+  // name:    What to call the pool in the snapshot.
+  static MemoryStats stats(const char *name)
+  {
+    MemoryStats stats;
+    stats.name = name;
+    stats.objectSize = sizeof(DataType);
+    stats.reservedBytes = reservedBytes.load(std::memory_order_relaxed);
+    stats.inUseBytes = heldObjects.load(std::memory_order_relaxed) * sizeof(DataType);
+    stats.highWaterBytes = highWaterObjects.load(std::memory_order_relaxed) * sizeof(DataType);
+    stats.fallbackAllocations = fallbackSlabs.load(std::memory_order_relaxed);
+    stats.retiredBytes = retiredObjects.load(std::memory_order_relaxed) * sizeof(DataType);
+    return stats;
   }
   // Report how many times the pool was used.
   static void report()
@@ -134,23 +461,73 @@ public:
 };
 
 template <typename DataType>
-bool Allocator<DataType>::isInit = false;
+thread_local typename Allocator<DataType>::Magazine *Allocator<DataType>::loaded = NULL;
+
+template <typename DataType>
+thread_local typename Allocator<DataType>::Magazine *Allocator<DataType>::spare = NULL;
 
 template <typename DataType>
-thread_local size_t Allocator<DataType>::threadNum = SIZE_MAX;
+thread_local size_t Allocator<DataType>::slabMagazines = 1;
 
 template <typename DataType>
-std::vector<std::vector<DataType *> *> Allocator<DataType>::pool;
+TaggedStack<typename Allocator<DataType>::Magazine> Allocator<DataType>::fullDepot;
+
+template <typename DataType>
+TaggedStack<typename Allocator<DataType>::Magazine> Allocator<DataType>::emptyDepot;
+
+template <typename DataType>
+std::atomic<typename Allocator<DataType>::Share *> Allocator<DataType>::shares(NULL);
+
+template <typename DataType>
+size_t Allocator<DataType>::shareMagazines = 0;
+
+template <typename DataType>
+thread_local typename Allocator<DataType>::Share *Allocator<DataType>::share = NULL;
+
+template <typename DataType>
+thread_local typename Allocator<DataType>::Magazine *Allocator<DataType>::owned = NULL;
+
+template <typename DataType>
+std::atomic<size_t> Allocator<DataType>::reservedBytes(0);
+
+template <typename DataType>
+std::atomic<size_t> Allocator<DataType>::heldObjects(0);
+
+template <typename DataType>
+std::atomic<size_t> Allocator<DataType>::highWaterObjects(0);
+
+template <typename DataType>
+std::atomic<size_t> Allocator<DataType>::fallbackSlabs(0);
+
+template <typename DataType>
+std::atomic<size_t> Allocator<DataType>::retiredObjects(0);
+
+template <typename DataType>
+thread_local size_t Allocator<DataType>::pendingRetired = 0;
 
 #ifdef ALLOC_COUNT
 template <typename DataType>
 std::atomic<size_t> Allocator<DataType>::count(0);
 #endif
 
-void threadAllocatorInit(int threadNum);
+// Attach the calling thread to the ThreadRegistry and initialize its allocators.
+void threadAllocatorInit();
+
+// Release the calling thread's allocator caches and detach it from the ThreadRegistry.
+void threadAllocatorFinish();
 
-void allocatorInit();
+// Get a snapshot of the memory use of every pool and of the regions behind MemAllocator.
+std::vector<MemoryStats> memoryStats();
+
+// Reserve allocator shares for a known workload, so allocation stays out of its timed section.
+// With no workload, nothing is reserved and the allocators grow as threads need objects.
+// threads:         How many worker slots, counting from 0, to reserve shares for now. Without FIRST_TOUCH, they are also built here.
+// transactions:    How many transactions each worker is expected to run.
+// transactionSize: How many operations each transaction holds.
+void allocatorInit(size_t threads = 0, size_t transactions = 0, size_t transactionSize = 0);
 
 void allocatorReport();
 
+END_ENGINE_NAMESPACE
+
 #endif
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "announcements.hpp"
+#include "transaction.hpp"
+
+BEGIN_ENGINE_NAMESPACE
+
+#if defined(WAIT_FREE) && (defined(SEGMENTVEC) || defined(COMPACTVEC))
+
+Announcements::Announcements()
+{
+	for (size_t i = 0; i < ANNOUNCE_SLOTS; i++)
+	{
+		slots[i].store(NULL);
+	}
+	nextTicket.store(1);
+	used.store(0);
+	return;
+}
+
+size_t Announcements::announce(Desc *descriptor)
+{
+	// The ticket must be visible before the transaction is.
+	descriptor->ticket.store(nextTicket.fetch_add(1));
+	size_t slot = ThreadRegistry::slot();
+	if (slot >= ANNOUNCE_SLOTS)
+	{
+		return ThreadRegistry::NONE;
+	}
+	size_t highest = used.load();
+	while (highest <= slot && !used.compare_exchange_weak(highest, slot + 1))
+	{
+		continue;
+	}
+	slots[slot].store(descriptor);
+	return slot;
+}
+
+void Announcements::withdraw(size_t slot)
+{
+	if (slot != ThreadRegistry::NONE)
+	{
+		slots[slot].store(NULL);
+	}
+	return;
+}
+
+Desc *Announcements::oldest(size_t ticket)
+{
+	Desc *found = NULL;
+	size_t foundTicket = ticket;
+	size_t count = used.load();
+	for (size_t i = 0; i < count; i++)
+	{
+		Desc *descriptor = slots[i].load();
+		if (descriptor == NULL)
+		{
+			continue;
+		}
+		size_t announced = descriptor->ticket.load();
+		if (announced < foundTicket && descriptor->status.load() == Desc::TxStatus::active)
+		{
+			found = descriptor;
+			foundTicket = announced;
+		}
+	}
+	return found;
+}
+
+#endif
+
+END_ENGINE_NAMESPACE
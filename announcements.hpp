@@ -0,0 +1,51 @@
+/*
+This file holds the announcement array of the wait-free mode.
+Each thread publishes the transaction it is running in its own slot, and every thread helps the older announced transactions before its own.
+A transaction is only passed over by the transactions already running when it was announced, so none can starve.
+*/
+#ifndef ANNOUNCEMENTS_HPP
+#define ANNOUNCEMENTS_HPP
+
+#include <atomic>
+#include <cstddef>
+
+#include "define.hpp"
+#include "threadRegistry.hpp"
+
+BEGIN_ENGINE_NAMESPACE
+
+// Only the lock-free vectors help each other, so the rest have nothing to announce.
+#if defined(WAIT_FREE) && (defined(SEGMENTVEC) || defined(COMPACTVEC))
+
+struct Desc;
+
+class Announcements
+{
+private:
+	// The transaction each thread is running, by registry slot.
+	std::atomic<Desc *> slots[ANNOUNCE_SLOTS];
+	// The ticket of the next transaction announced.
+	// Starts at 1, since 0 marks a transaction that was never announced.
+	std::atomic<size_t> nextTicket;
+	// One past the highest slot ever announced in, so scans skip the slots no thread has used.
+	std::atomic<size_t> used;
+
+public:
+	Announcements();
+
+	// Give a transaction a ticket and publish it in the calling thread's slot.
+	// Threads without a slot still get a ticket, so they help the same older transactions, but nobody helps theirs.
+	// Returns the slot to withdraw it from, or ThreadRegistry::NONE if the thread has none to announce in.
+	size_t announce(Desc *descriptor);
+	// Stop publishing a transaction once it is done.
+	void withdraw(size_t slot);
+	// Get the oldest announced transaction that is still active and older than a ticket, or NULL if there is none.
+	// A thread helps these one at a time, so it always finishes the longest waiting first.
+	Desc *oldest(size_t ticket);
+};
+
+#endif
+
+END_ENGINE_NAMESPACE
+
+#endif
@@ -0,0 +1,141 @@
+#include "appendLog.hpp"
+#include "transaction.hpp"
+
+BEGIN_ENGINE_NAMESPACE
+
+#if defined(SEGMENTVEC) || defined(COMPACTVEC)
+
+// A value and its tag must fit in one atomic word.
+static_assert(sizeof(VAL) <= sizeof(uint32_t), "Log entries pack a value into 32 bits.");
+static_assert((LOG_FIRST_BUCKET & (LOG_FIRST_BUCKET - 1)) == 0, "LOG_FIRST_BUCKET must be a power of 2.");
+
+AppendLog::AppendLog()
+{
+	for (size_t i = 0; i < LOG_BUCKETS; i++)
+	{
+		buckets[i].store(NULL);
+	}
+	tail.store(0);
+	return;
+}
+
+std::atomic<uint64_t> *AppendLog::locate(size_t position, bool allocate)
+{
+	// Offset by the first bucket's size, so the highest bit picks the bucket and the rest is the offset into it.
+	size_t pos = position + LOG_FIRST_BUCKET;
+	size_t hiBit = (sizeof(unsigned long long) * 8) - __builtin_clzll(pos) - 1;
+	size_t bucket = hiBit - __builtin_ctzll(LOG_FIRST_BUCKET);
+	if (bucket >= LOG_BUCKETS)
+	{
+		return NULL;
+	}
+	std::atomic<uint64_t> *entries = buckets[bucket].load();
+	if (entries == NULL)
+	{
+		if (!allocate)
+		{
+			return NULL;
+		}
+		// Zeroed entries read as unpublished.
+		std::atomic<uint64_t> *mem = new std::atomic<uint64_t>[(size_t)1 << hiBit]();
+		if (buckets[bucket].compare_exchange_strong(entries, mem))
+		{
+			entries = mem;
+		}
+		else
+		{
+			// Another thread already allocated this bucket.
+			delete[] mem;
+		}
+	}
+	return &entries[pos ^ ((size_t)1 << hiBit)];
+}
+
+void AppendLog::append(Desc *descriptor)
+{
+#ifdef METRICS
+	descriptor->startTime = std::chrono::high_resolution_clock::now();
+	// Appends don't use pre-processing.
+	descriptor->preprocessTime = descriptor->startTime;
+#endif
+	bool valid = descriptor->groups == NULL;
+	for (size_t i = 0; valid && i < descriptor->size; i++)
+	{
+		valid = descriptor->ops[i].type == Operation::OpType::pushBack;
+	}
+	if (!valid)
+	{
+		descriptor->abort(AbortCause::invalid);
+	}
+	else if (descriptor->size > LENGTH)
+	{
+		// A range this long can't be tagged, so it is never reserved.
+		descriptor->abort(AbortCause::outOfBounds);
+	}
+	else if (descriptor->size == 0)
+	{
+		descriptor->status.store(Desc::TxStatus::committed);
+	}
+	else
+	{
+		uint32_t length = (uint32_t)descriptor->size;
+		size_t start = tail.fetch_add(length);
+		std::atomic<uint64_t> *head = locate(start, true);
+		// Buckets only grow toward the end, so the whole range fits if its last position does.
+		if (locate(start + length - 1, true) == NULL)
+		{
+			// Later ranges only reach further, so a tombstone is only needed if this one starts inside the log.
+			if (head != NULL)
+			{
+				head->store(pack(HEAD | length, UNSET), std::memory_order_release);
+			}
+			descriptor->abort(AbortCause::outOfBounds);
+		}
+		else
+		{
+			for (uint32_t i = 1; i < length; i++)
+			{
+				locate(start + i, true)->store(pack(LIVE, descriptor->ops[i].val), std::memory_order_relaxed);
+			}
+			// Publish the range. Readers that see the marker also see the rest of it.
+			head->store(pack(HEAD | LIVE | length, descriptor->ops[0].val), std::memory_order_release);
+			descriptor->status.store(Desc::TxStatus::committed);
+		}
+	}
+#ifdef METRICS
+	descriptor->endTime = std::chrono::high_resolution_clock::now();
+#endif
+	return;
+}
+
+size_t AppendLog::read(size_t &cursor, VAL *out, size_t max)
+{
+	size_t copied = 0;
+	while (copied < max)
+	{
+		std::atomic<uint64_t> *entry = locate(cursor, false);
+		if (entry == NULL)
+		{
+			break;
+		}
+		uint64_t found = entry->load(std::memory_order_acquire);
+		uint32_t tag = found >> 32;
+		if (tag == 0)
+		{
+			break;
+		}
+		if ((tag & HEAD) != 0 && (tag & LIVE) == 0)
+		{
+			// Skip the whole tombstone.
+			cursor += tag & LENGTH;
+			continue;
+		}
+		out[copied++] = (VAL)found;
+		cursor++;
+	}
+	return copied;
+}
+
+#endif
+
+END_ENGINE_NAMESPACE
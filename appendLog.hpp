@@ -0,0 +1,65 @@
+/*
+This file holds the append-only log of a vector in log mode.
+A push-only transaction reserves a range of positions with a single fetch-add, so appends never contend on size or wait for each other.
+It fills the range, then publishes it by writing a marker on its first position.
+A transaction that can't fit marks its range as a tombstone instead, and readers skip it.
+*/
+#ifndef APPENDLOG_HPP
+#define APPENDLOG_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "define.hpp"
+
+BEGIN_ENGINE_NAMESPACE
+
+// Only the lock-free vectors have a size every push contends on, so the rest have no log mode.
+#if defined(SEGMENTVEC) || defined(COMPACTVEC)
+
+struct Desc;
+
+class AppendLog
+{
+private:
+	// Each position holds its value in the low half and a tag in the high half.
+	// The first position of a range is tagged HEAD, plus LIVE if the range committed, plus the range's length.
+	// The other positions of a committed range are only tagged LIVE. They are written before the first, so a reader that passed the marker always finds them.
+	// A tag of 0 means the range starting there isn't published yet.
+	static const uint32_t HEAD = (uint32_t)1 << 31;
+	static const uint32_t LIVE = (uint32_t)1 << 30;
+	static const uint32_t LENGTH = LIVE - 1;
+
+	// The position buckets, allocated as appends reach them.
+	std::atomic<std::atomic<uint64_t> *> buckets[LOG_BUCKETS];
+	// One past the last position reserved.
+	std::atomic<size_t> tail;
+
+	static uint64_t pack(uint32_t tag, VAL val)
+	{
+		return ((uint64_t)tag << 32) | val;
+	}
+	// Get the entry at a position.
+	// allocate:    Whether to allocate its bucket if no append has yet.
+	// Returns NULL if the position is past the log's capacity, or its bucket isn't allocated and allocate is false.
+	std::atomic<uint64_t> *locate(size_t position, bool allocate);
+
+public:
+	AppendLog();
+
+	// Run a push-only transaction.
+	// Any other operation, or a transaction spanning several vectors, aborts it as invalid.
+	void append(Desc *descriptor);
+	// Copy out the values of committed appends in log order, skipping tombstones.
+	// cursor:  The position to read from. Start at 0, and pass the cursor left by the last call to continue.
+	// out:     Gets up to max values.
+	// Returns the number of values copied. Stops early at the first range still being appended.
+	size_t read(size_t &cursor, VAL *out, size_t max);
+};
+
+#endif
+
+END_ENGINE_NAMESPACE
+
+#endif
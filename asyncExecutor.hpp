@@ -0,0 +1,187 @@
+/*
+This file holds a pool of worker threads that run transactions for their callers.
+Submitting a transaction returns right away, so a caller can keep many transactions in flight and overlap them with other work.
+Executors run descriptors on one engine's vector. Engine has no submit of its own yet, so callers picking an engine at runtime have to run their own threads around execute.
+*/
+#ifndef ASYNCEXECUTOR_HPP
+#define ASYNCEXECUTOR_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "allocator.hpp"
+#include "define.hpp"
+#include "transaction.hpp"
+
+BEGIN_ENGINE_NAMESPACE
+
+template <class Vector>
+class AsyncExecutor;
+
+// Tracks one submitted transaction.
+// The caller owns it, so submitting allocates nothing. It must stay in place until the transaction is done.
+class Completion
+{
+	template <class Vector>
+	friend class AsyncExecutor;
+
+public:
+	enum State
+	{
+		// Never submitted.
+		idle,
+		pending,
+		committed,
+		aborted
+	};
+	// Run on the worker thread once the transaction is done.
+	typedef std::function<void(Desc *desc, bool committed)> Callback;
+
+private:
+	std::atomic<State> state;
+	Desc *desc = NULL;
+	Callback callback;
+	// Links the queue of submitted transactions.
+	Completion *next = NULL;
+
+public:
+	Completion() : state(idle) {}
+	explicit Completion(Callback callback) : state(idle), callback(callback) {}
+	Completion(const Completion &) = delete;
+	Completion &operator=(const Completion &) = delete;
+
+	// Check if the transaction is done, without waiting.
+	// Returns false if nothing was submitted.
+	bool ready() const
+	{
+		State current = state.load();
+		return current == committed || current == aborted;
+	}
+	// Wait for the transaction to finish.
+	// Returns true if it committed, and false right away if nothing was submitted.
+	bool wait() const
+	{
+		State current;
+		while ((current = state.load()) == pending)
+		{
+			std::this_thread::yield();
+		}
+		return current == committed;
+	}
+};
+
+// Runs transactions on a vector from a pool of worker threads.
+template <class Vector>
+class AsyncExecutor
+{
+private:
+	Vector *vector;
+	std::vector<std::thread> workers;
+	// Guards the queue. Workers sleep on ready while it is empty.
+	std::mutex lock;
+	std::condition_variable ready;
+	Completion *head = NULL;
+	Completion *tail = NULL;
+	bool stopping = false;
+
+	// Take the next transaction off the queue, waiting for one if needed.
+	// Returns NULL once the executor is stopping and the queue is empty.
+	Completion *take()
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		ready.wait(guard, [this] { return head != NULL || stopping; });
+		Completion *completion = head;
+		if (completion != NULL)
+		{
+			head = completion->next;
+			if (head == NULL)
+			{
+				tail = NULL;
+			}
+		}
+		return completion;
+	}
+
+	void work()
+	{
+		threadAllocatorInit();
+		Completion *completion;
+		while ((completion = take()) != NULL)
+		{
+			Desc *desc = completion->desc;
+#ifdef BOOSTEDVEC
+			bool committed = vector->executeTransaction(desc);
+#else
+			vector->executeTransaction(desc);
+			bool committed = desc->status.load() == Desc::TxStatus::committed;
+#endif
+			// The caller may reuse or free the completion as soon as its state changes, so the callback runs first.
+			if (completion->callback)
+			{
+				completion->callback(desc, committed);
+			}
+			completion->state.store(committed ? Completion::State::committed : Completion::State::aborted);
+		}
+		threadAllocatorFinish();
+		return;
+	}
+
+public:
+	// Start the workers.
+	// vector:  The vector to run transactions on. Must outlive the executor.
+	// threads: The number of worker threads.
+	AsyncExecutor(Vector *vector, size_t threads = THREAD_COUNT) : vector(vector)
+	{
+		for (size_t i = 0; i < threads; i++)
+		{
+			workers.emplace_back(&AsyncExecutor::work, this);
+		}
+	}
+	AsyncExecutor(const AsyncExecutor &) = delete;
+	AsyncExecutor &operator=(const AsyncExecutor &) = delete;
+	// Finish every submitted transaction, then stop the workers.
+	~AsyncExecutor()
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			stopping = true;
+		}
+		ready.notify_all();
+		for (std::thread &worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	// Queue a transaction and return without waiting for it.
+	// desc:        The transaction. Read its results once completion reports it committed.
+	// completion:  Tracks the transaction. Must not be tracking another one still in flight.
+	void submit(Desc *desc, Completion &completion)
+	{
+		completion.desc = desc;
+		completion.next = NULL;
+		completion.state.store(Completion::State::pending);
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if (tail == NULL)
+			{
+				head = &completion;
+			}
+			else
+			{
+				tail->next = &completion;
+			}
+			tail = &completion;
+		}
+		ready.notify_one();
+		return;
+	}
+};
+
+END_ENGINE_NAMESPACE
+
+#endif
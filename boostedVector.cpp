@@ -1,5 +1,7 @@
 #include "boostedVector.hpp"
 
+BEGIN_ENGINE_NAMESPACE
+
 #ifdef BOOSTEDVEC
 
 void BoostedElement::print()
@@ -13,7 +15,7 @@ bool BoostedVector::reserve(size_t size)
     return array->reserve(size);
 }
 
-BoostedVector::BoostedVector()
+BoostedVector::BoostedVector(size_t ring)
 {
     // Initialize our internal segmented array.
     array = new SegmentedVector<BoostedElement>();
@@ -23,13 +25,43 @@ BoostedVector::BoostedVector()
         endTransaction = new Desc(0, NULL);
     }
     // Initialize size.
-    sizeLock.lock.lock();
-    size = 0;
-    sizeLock.lock.unlock();
+    size.store(0);
+    head.store(0);
+    if (ring != 0)
+    {
+        // Rings are a power of two, so positions wrap with a mask.
+        this->ring = 1;
+        while (this->ring < ring)
+        {
+            this->ring <<= 1;
+        }
+        // Every slot of the ring exists up front, so pushes onto either end never need to grow it.
+        reserve(this->ring);
+    }
     return;
 }
 
-bool BoostedVector::insertElements(Desc *descriptor)
+bool BoostedVector::bulkLoad(const VAL *values, size_t count, unsigned int threads)
+{
+    if (size.load() != 0 || (ring != 0 && count > ring) || !reserve(count))
+    {
+        return false;
+    }
+    // Split on whole runs of elements, so threads rarely share a cache line.
+    parallelFor(count, 64, threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            BoostedElement *element = NULL;
+            array->read(i, element);
+            element->val = values[i];
+        }
+    });
+    size.store(count);
+    head.store(0);
+    return true;
+}
+
+bool BoostedVector::lockElements(Desc *descriptor)
 {
     RWSet *set = descriptor->set;
     // Get the start of the map.
@@ -40,6 +72,7 @@ bool BoostedVector::insertElements(Desc *descriptor)
         BoostedElement *elem = NULL;
         if (!array->read(iter->first, elem))
         {
+            descriptor->abort(AbortCause::outOfBounds);
             return false;
         }
         // Lock the element.
@@ -47,7 +80,9 @@ bool BoostedVector::insertElements(Desc *descriptor)
         // Push the lock to the list so we can unlock it when the transaction completes.
         descriptor->locks.push_back(elem);
         // Abort if we are out of bounds.
-        if(iter->second->checkBounds == Assigned::yes && elem->val == UNSET) {
+        if (iter->second->checkBounds == RWOperation::Assigned::yes && elem->val == UNSET)
+        {
+            descriptor->abort(AbortCause::outOfBounds);
             return false;
         }
         // If any reads are pending.
@@ -58,25 +93,122 @@ bool BoostedVector::insertElements(Desc *descriptor)
                 iter->second->readList[i]->ret = elem->val;
             }
         }
-        // If a write is pending.
-        if (iter->second->lastWriteOp != NULL)
+        // Compare writes check the old value now that the element is locked.
+        Operation *compare = iter->second->compareOp;
+        if (compare != NULL && elem->val != compare->expected && compare->type == Operation::OpType::compareWriteOrAbort)
         {
-            elem->val = iter->second->lastWriteOp->val;
+            descriptor->abort(AbortCause::compareFailed);
+            return false;
+        }
+        // Size still counts the element, so an update may not leave it reading as unset.
+        if (iter->second->hasDelta && elem->val != UNSET && Operation::applyDelta(iter->second->deltaType, elem->val, iter->second->delta) == UNSET)
+        {
+            descriptor->abort(AbortCause::invalid);
+            return false;
         }
     }
     return true;
 }
 
+void BoostedVector::writeElements(Desc *descriptor)
+{
+    RWSet *set = descriptor->set;
+    // Every element is locked and checked, so the transaction can no longer abort.
+    // Writing only now means an abort while locking never leaves a partial update behind.
+    size_t i = 0;
+    for (auto iter = set->operations.rbegin(); iter != set->operations.rend(); ++iter, ++i)
+    {
+        BoostedElement *elem = descriptor->locks[i];
+        Operation *write = iter->second->lastWriteOp;
+        // Skip a compare write that found the wrong value, unless a later write in the transaction replaces it anyway.
+        if (write != NULL && write == iter->second->compareOp && elem->val != write->expected)
+        {
+            continue;
+        }
+        // If a write is pending.
+        if (write != NULL)
+        {
+            elem->val = write->val;
+        }
+        // Updates combine with the value under the lock. Unset elements stay unset.
+        else if (iter->second->hasDelta && elem->val != UNSET)
+        {
+            elem->val = Operation::applyDelta(iter->second->deltaType, elem->val, iter->second->delta);
+        }
+    }
+    // Size changes last for the same reason. Pure push and pop transactions already moved it when they reserved their slots.
+    if (set->hasSize && set->sizeMode == SizeLock::Mode::exclusive)
+    {
+        size.store(set->size);
+        head.store(set->head);
+    }
+    return;
+}
+
+void BoostedVector::releaseElements(Desc *descriptor)
+{
+    // Groups after one that failed to prepare never got a set.
+    if (descriptor->set == NULL)
+    {
+        return;
+    }
+    // Release all locks in the order obtained.
+    for (auto &&lockElem : descriptor->locks)
+    {
+        lockElem->lock.unlock();
+    }
+    descriptor->locks.clear();
+    sizeLock.unlock(descriptor->set->sizeMode);
+    // Nothing else ever sees a boosted set, so recycle it right away.
+    descriptor->set->retire();
+    descriptor->set = NULL;
+    return;
+}
+
+bool BoostedVector::executeGroups(std::vector<Desc *> *groups)
+{
+    // Prepare and lock every group before writing any, so the groups commit or abort together.
+    // Groups are sorted by vector, so every transaction takes size locks, then element locks, in the same order.
+    // Groups that share a vector abort the transaction as it is built, so it never runs.
+    bool ret = groups->front()->abortCause.load() == AbortCause::none;
+    for (auto group = groups->begin(); ret && group != groups->end(); ++group)
+    {
+        ret = (*group)->vector->prepareTransaction(*group);
+    }
+    for (auto group = groups->begin(); ret && group != groups->end(); ++group)
+    {
+        ret = (*group)->vector->lockElements(*group);
+    }
+    for (Desc *group : *groups)
+    {
+        if (ret)
+        {
+            group->vector->writeElements(group);
+        }
+        group->vector->releaseElements(group);
+    }
+    return ret;
+}
+
 bool BoostedVector::prepareTransaction(Desc *descriptor)
 {
     descriptor->set = Allocator<RWSet>::alloc();
     // Create the read/write set.
-    descriptor->set->createSet(descriptor, this);
+    // Do not touch the elements if the set itself failed (popping an empty vector, for example).
+    if (!descriptor->set->createSet(descriptor, this))
+    {
+        return false;
+    }
 #ifdef METRICS
     descriptor->preprocessTime = std::chrono::high_resolution_clock::now();
 #endif
     // Ensure that we can fit all of the elements we plan to insert.
-    return reserve(descriptor->set->maxReserveAbsolute > descriptor->set->size ? descriptor->set->maxReserveAbsolute : descriptor->set->size);
+    if (!reserve(descriptor->set->maxReserveAbsolute > descriptor->set->size ? descriptor->set->maxReserveAbsolute : descriptor->set->size))
+    {
+        descriptor->abort(AbortCause::outOfBounds);
+        return false;
+    }
+    return true;
 }
 
 bool BoostedVector::executeTransaction(Desc *descriptor)
@@ -85,19 +217,30 @@ bool BoostedVector::executeTransaction(Desc *descriptor)
     descriptor->startTime = std::chrono::high_resolution_clock::now();
 #endif
 
-    bool ret = prepareTransaction(descriptor) && insertElements(descriptor);
+    // Transactions spanning several vectors run each group on its own vector.
+    if (descriptor->groups != NULL)
+    {
+        bool ret = executeGroups(descriptor->groups);
+#ifdef METRICS
+        descriptor->endTime = std::chrono::high_resolution_clock::now();
+#endif
+        return ret;
+    }
+
+    bool ret = prepareTransaction(descriptor) && lockElements(descriptor);
+    if (ret)
+    {
+        writeElements(descriptor);
+    }
 
 #ifdef METRICS
     descriptor->endTime = std::chrono::high_resolution_clock::now();
 #endif
 
-    // As the transaction has completed, release all locks in the order obtained.
+    // As the transaction has completed, release everything it holds.
     // Always unlock, regardless of what the functions return.
     // Otherwise, we would hold on to these locks forever.
-    for (auto &&lockElem : descriptor->locks)
-    {
-        lockElem->lock.unlock();
-    }
+    releaseElements(descriptor);
     return ret;
 }
 
@@ -116,4 +259,6 @@ void BoostedVector::printContents()
     return;
 }
 
-#endif
\ No newline at end of file
+#endif
+
+END_ENGINE_NAMESPACE
\ No newline at end of file
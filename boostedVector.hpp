@@ -5,13 +5,18 @@
 #include <atomic>
 #include <map>
 #include <mutex>
+#include <vector>
 
 #include "allocator.hpp"
 #include "define.hpp"
 #include "rwSet.hpp"
+#include "parallelFor.hpp"
 #include "segmentedVector.hpp"
+#include "sizeLock.hpp"
 #include "transaction.hpp"
 
+BEGIN_ENGINE_NAMESPACE
+
 #ifdef BOOSTEDVEC
 
 class RWOperation;
@@ -36,23 +41,43 @@ private:
     // A generic, committed transaction.
     // This is used to resolve uninitialized pages.
     Desc *endTransaction = NULL;
-    // Reserve simply passes the request along to the underlying segmented vector.
-    bool reserve(size_t size);
     // Locks and updates an element.
     bool updateElement(size_t index, VAL newElem);
-    // Insert the elements in the set.
-    bool insertElements(Desc *descriptor);
+    // Lock the elements in the set and check them, without writing anything.
+    // Returns false if the transaction must abort.
+    bool lockElements(Desc *descriptor);
+    // Write the elements in the set, once they are all locked and checked.
+    void writeElements(Desc *descriptor);
+    // Release the locks a transaction holds and recycle its set.
+    void releaseElements(Desc *descriptor);
+    // Run every group of a transaction spanning several vectors.
+    static bool executeGroups(std::vector<Desc *> *groups);
     // Create a RWSet for the transaction.
     bool prepareTransaction(Desc *descriptor);
 
 public:
     // The vector's shared size variable.
     // Access is public because the RWSet must be able to change it.
-    size_t size;
-    // NOTE: Only use the lock here, never the value.
-    BoostedElement sizeLock;
-    // Default constructor.
-    BoostedVector();
+    // Atomic so commuting pushes and pops can reserve their slots without holding size exclusively.
+    std::atomic<size_t> size;
+    // The ring position of the first element, if the vector is a deque.
+    // Only changes under the size lock held exclusively.
+    std::atomic<size_t> head;
+    // The number of elements a deque can hold, or 0 for a plain vector.
+    size_t ring = 0;
+    // The semantic lock guarding size.
+    SizeLock sizeLock;
+    // Reserve simply passes the request along to the underlying segmented vector.
+    // Access is public because pushes reserve their slots from the RWSet.
+    bool reserve(size_t size);
+    // Build a vector.
+    // ring:    Makes the vector a deque that can hold this many elements, rounded up to a power of two. 0 for a plain vector.
+    explicit BoostedVector(size_t ring = 0);
+    // Fill an empty vector without running transactions, writing elements straight into the array.
+    // Only valid before any transaction runs, and before any other thread has the vector.
+    // threads: The number of threads that write elements, each for its own range of them.
+    // Returns false if the vector isn't empty, or the values don't fit.
+    bool bulkLoad(const VAL *values, size_t count, unsigned int threads);
     // Apply a transaction to a vector.
     bool executeTransaction(Desc *descriptor);
     // Print out the values stored in the vector.
@@ -60,4 +85,7 @@ public:
 };
 
 #endif
+
+END_ENGINE_NAMESPACE
+
 #endif
\ No newline at end of file
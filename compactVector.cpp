@@ -1,4 +1,7 @@
 #include "compactVector.hpp"
+#include "epoch.hpp"
+
+BEGIN_ENGINE_NAMESPACE
 
 #ifdef COMPACTVEC
 
@@ -28,6 +31,8 @@ bool CompactVector::reserve(size_t size)
 
 bool CompactVector::updateElement(size_t index, CompactElement &newElem)
 {
+    // A compare write may keep the old value instead, so remember the value to write.
+    VAL writeVal = newElem.newVal;
     CompactElement oldElem;
     do
     {
@@ -35,7 +40,7 @@ bool CompactVector::updateElement(size_t index, CompactElement &newElem)
         if (!array->read(index, oldElem))
         {
             // Failure means the transaction attempted an invalid read or write, as the vector wasn't allocated to this point.
-            newElem.descriptor->status.store(Desc::TxStatus::aborted);
+            newElem.descriptor->abort(AbortCause::outOfBounds);
             // DEBUG: Abort reporting.
             //printf("Aborted!\n");
             // No need to even try anymore. The whole transaction failed.
@@ -80,14 +85,15 @@ bool CompactVector::updateElement(size_t index, CompactElement &newElem)
             status = oldDesc->status.load();
         }
 
-        // We only get the new value if it was write committed.
-        // Also check if it matches the end transaction, as that is a special case where we should see a write, even though the set is empty.
+        // We only get the new value if it committed.
+        // Elements a transaction only read hold their old value as the new one too, so the finished transaction's set is never needed.
+        // The end transaction counts as committed, which covers elements nothing has written yet.
         RWOperation *op = NULL;
-        if (oldDesc == endTransaction || (status == Desc::TxStatus::committed && oldDesc->set.load()->getOp(op, index) && op->lastWriteOp != NULL))
+        if (status == Desc::TxStatus::committed)
         {
             newElem.oldVal = oldElem.newVal;
         }
-        // Transaction was aborted or operation was a read.
+        // Transaction was aborted.
         // Grab the old page's old value.
         else
         {
@@ -99,12 +105,50 @@ bool CompactVector::updateElement(size_t index, CompactElement &newElem)
         newElem.descriptor->set.load()->getOp(op, index);
         if (op != NULL && op->checkBounds == RWOperation::Assigned::yes && newElem.oldVal == UNSET)
         {
-            newElem.descriptor->status.store(Desc::TxStatus::aborted);
+            newElem.descriptor->abort(AbortCause::outOfBounds);
             // DEBUG: Abort reporting.
             //printf("Aborted!\n");
             // No need to even try anymore. The whole transaction failed.
             return false;
         }
+
+        // Compare writes check the old value now. This decides again on every retry, since the old value may have changed.
+        if (op != NULL && op->compareOp != NULL)
+        {
+            if (newElem.oldVal == op->compareOp->expected)
+            {
+                newElem.newVal = writeVal;
+            }
+            else if (op->compareOp->type == Operation::OpType::compareWriteOrAbort)
+            {
+                newElem.descriptor->abort(AbortCause::compareFailed);
+                return false;
+            }
+            // Skip the write by keeping the old value, unless a later write in the transaction replaces it anyway.
+            else if (op->lastWriteOp == op->compareOp)
+            {
+                newElem.newVal = newElem.oldVal;
+            }
+        }
+
+        // Elements only read keep their value, whether or not the transaction commits.
+        if (op == NULL || !op->writes())
+        {
+            newElem.newVal = newElem.oldVal;
+        }
+
+        // Updates combine with the old value now, and again on every retry.
+        // An element only holds one pending value, so concurrent updates to it still take turns.
+        if (op != NULL && op->hasDelta)
+        {
+            newElem.newVal = (newElem.oldVal == UNSET) ? UNSET : Operation::applyDelta(op->deltaType, newElem.oldVal, op->delta);
+            // Size still counts the element, so an update may not leave it reading as unset.
+            if (newElem.oldVal != UNSET && newElem.newVal == UNSET)
+            {
+                newElem.descriptor->abort(AbortCause::invalid);
+                return false;
+            }
+        }
     } while (!array->tryWrite(index, oldElem, newElem));
 
     // Store the old value in the associated operations.
@@ -202,6 +246,11 @@ bool CompactVector::prepareTransaction(Desc *descriptor)
     RWSet *set = descriptor->set.load();
     if (set == NULL)
     {
+        // A transaction that finished without a set never gets one, and its operations may already be freed.
+        if (descriptor->status.load() != Desc::TxStatus::active)
+        {
+            return false;
+        }
         // Initialize the RWSet object.
         set = Allocator<RWSet>::alloc();
 
@@ -212,15 +261,18 @@ bool CompactVector::prepareTransaction(Desc *descriptor)
         set->createSet(descriptor, this);
 
         RWSet *nullVal = NULL;
-        descriptor->set.compare_exchange_strong(nullVal, set);
-        // TODO2: Preferably deallocate if we fail to CAS.
+        if (!descriptor->set.compare_exchange_strong(nullVal, set))
+        {
+            // Another thread published its set first. Nobody else has seen ours.
+            set->retire();
+        }
     }
     // Make sure we only work with the set that succeeded first.
     set = descriptor->set.load();
     // Ensure that we can fit all of the elements we plan to insert.
     if (!reserve(set->maxReserveAbsolute > set->size ? set->maxReserveAbsolute : set->size))
     {
-        descriptor->status.store(Desc::TxStatus::aborted);
+        descriptor->abort(AbortCause::outOfBounds);
         // DEBUG: Abort reporting.
         //printf("Aborted!\n");
         return false;
@@ -232,6 +284,14 @@ bool CompactVector::completeTransaction(Desc *descriptor, unsigned int startElem
 {
     // Insert the elements.
     insertElements(descriptor->set.load(), startElement);
+    if (descriptor->groups != NULL)
+    {
+        // A group's elements only go in after every group before it, so only the groups after this one can be missing.
+        for (auto i = std::find(descriptor->groups->begin(), descriptor->groups->end(), descriptor) + 1; i != descriptor->groups->end(); ++i)
+        {
+            (*i)->vector->insertElements((*i)->set.load());
+        }
+    }
 
     auto active = Desc::TxStatus::active;
     auto committed = Desc::TxStatus::committed;
@@ -252,18 +312,144 @@ bool CompactVector::completeTransaction(Desc *descriptor, unsigned int startElem
     return true;
 }
 
+void CompactVector::executeGroups(std::vector<Desc *> *groups)
+{
+    for (Desc *group : *groups)
+    {
+        if (group->status.load() != Desc::TxStatus::active)
+        {
+            return;
+        }
+        if (!group->vector->prepareTransaction(group))
+        {
+            return;
+        }
+    }
+    groups->front()->vector->completeTransaction(groups->front());
+    return;
+}
+
 void CompactVector::executeTransaction(Desc *descriptor)
 {
+    {
+        // Any thread running a transaction may help another one, so every thread does so inside a guard.
+        EpochGuard guard;
+        submitTransaction(descriptor);
+    }
+    descriptor->retireSets();
+    return;
+}
+
+void CompactVector::submitTransaction(Desc *descriptor)
+{
+    // A log can't take part in a transaction spanning several vectors, since its appends aren't ordered with anything else.
+    if (descriptor->groups != NULL)
+    {
+        for (Desc *group : *descriptor->groups)
+        {
+            if (group->vector->log != NULL)
+            {
+                descriptor->abort(AbortCause::invalid);
+                return;
+            }
+        }
+    }
+    // Appends never conflict, so they skip announcing and helping.
+    if (log != NULL)
+    {
+        log->append(descriptor);
+        return;
+    }
+    // Try elimination before announcing, so no helper can run the transaction while it waits for a partner.
+    if (eliminable(descriptor) && elimination.exchange(descriptor))
+    {
+        return;
+    }
+#ifdef WAIT_FREE
+    size_t slot = announcements.announce(descriptor);
+    // Finish every transaction announced before this one, oldest first.
+    for (Desc *older = announcements.oldest(descriptor->ticket.load()); older != NULL; older = announcements.oldest(descriptor->ticket.load()))
+    {
+        sizeHelp(older);
+    }
+    runTransaction(descriptor);
+    announcements.withdraw(slot);
+#else
+    runTransaction(descriptor);
+#endif
+    return;
+}
+
+bool CompactVector::eliminable(Desc *descriptor)
+{
+    if (descriptor->groups != NULL || descriptor->size != 1)
+    {
+        return false;
+    }
+    Operation::OpType type = descriptor->ops[0].type;
+    if (type != Operation::OpType::pushBack && type != Operation::OpType::popBack)
+    {
+        return false;
+    }
+    // Waiting for a partner costs more than an uncontended size update, so only back off while another transaction holds size.
+    Desc *holder = size.load().descriptor;
+    return holder != NULL && holder->status.load() == Desc::TxStatus::active;
+}
+
+void CompactVector::makeLog()
+{
+    log = new AppendLog();
+    return;
+}
+
+bool CompactVector::bulkLoad(const VAL *values, size_t count, unsigned int threads)
+{
+    CompactElement current = size.load();
+    bool committed = current.descriptor == NULL || current.descriptor->status.load() == Desc::TxStatus::committed;
+    if (log != NULL || (committed ? current.newVal : current.oldVal) != 0 || count > UINT32_MAX || !reserve(count))
+    {
+        return false;
+    }
+    // Split on cache lines, so threads don't share one.
+    parallelFor(count, 64 / sizeof(CompactElement), threads, [&](size_t begin, size_t end) {
+        // Elements written by the generic committed transaction read as their new values.
+        CompactElement element;
+        element.descriptor = endTransaction;
+        for (size_t i = begin; i < end; i++)
+        {
+            element.newVal = values[i];
+            array->write(i, element);
+        }
+    });
+    CompactElement sizeElem;
+    sizeElem.oldVal = count;
+    sizeElem.newVal = count;
+    sizeElem.descriptor = endTransaction;
+    size.store(sizeElem);
+    return true;
+}
+
+void CompactVector::runTransaction(Desc *descriptor)
+{
+    // Transactions spanning several vectors run each group on its own vector.
+    if (descriptor->groups != NULL)
+    {
+        executeGroups(descriptor->groups);
+        return;
+    }
 #ifdef METRICS
     descriptor->startTime = std::chrono::high_resolution_clock::now();
 #endif
     // Initialize the set for the descriptor.
-    prepareTransaction(descriptor);
+    bool prepared = prepareTransaction(descriptor);
 #ifdef METRICS
     descriptor->preprocessTime = std::chrono::high_resolution_clock::now();
 #endif
-    // Complete the transaction.
-    completeTransaction(descriptor);
+    // Complete the transaction, unless it already aborted while preparing.
+    if (prepared)
+    {
+        completeTransaction(descriptor);
+    }
 #ifdef METRICS
     descriptor->endTime = std::chrono::high_resolution_clock::now();
 #endif
@@ -274,8 +460,17 @@ void CompactVector::sizeHelp(Desc *descriptor)
     // DEBUG: Print the thread id that is helping.
     //printf("Thread %lu is helping descriptor %p\n", std::hash<std::thread::id>{}(std::this_thread::get_id()), descriptor);
 
+    // Groups are prepared one after another, so the groups after this one may not be ready yet.
+    if (descriptor->groups != NULL)
+    {
+        executeGroups(descriptor->groups);
+        return;
+    }
     // Must actually start at the very beginning.
-    prepareTransaction(descriptor);
+    if (!prepareTransaction(descriptor))
+    {
+        return;
+    }
     // Must help from the beginning of the list, since we didn't help part way through.
     completeTransaction(descriptor);
 }
@@ -296,4 +491,6 @@ void CompactVector::printContents()
     return;
 }
 
-#endif
\ No newline at end of file
+#endif
+
+END_ENGINE_NAMESPACE
\ No newline at end of file
@@ -1,16 +1,24 @@
 #ifndef COMPACT_VECTOR_HPP
 #define COMPACT_VECTOR_HPP
 
+#include <algorithm>
 #include <assert.h>
 #include <atomic>
 #include <map>
+#include <vector>
 
 #include "allocator.hpp"
+#include "announcements.hpp"
+#include "appendLog.hpp"
+#include "elimination.hpp"
+#include "parallelFor.hpp"
 #include "define.hpp"
 #include "rwSet.hpp"
 #include "segmentedVector.hpp"
 #include "transaction.hpp"
 
+BEGIN_ENGINE_NAMESPACE
+
 #ifdef COMPACTVEC
 
 class RWOperation;
@@ -37,6 +45,10 @@ private:
     // A generic, committed transaction.
     // This is used to resolve uninitialized pages.
     Desc *endTransaction = NULL;
+#ifdef WAIT_FREE
+    // The transactions each thread is running on this vector.
+    Announcements announcements;
+#endif
     // Reserve simply passes the request along to the underlying segmented vector.
     bool reserve(size_t size);
     // Performs an atomic 16 byte exchange of an element.
@@ -48,7 +60,20 @@ private:
     bool prepareTransaction(Desc *descriptor);
     // Finish the vector transaction.
     // Used for helping.
+    // A group of a transaction spanning several vectors also inserts the groups after it, on their own vectors.
     bool completeTransaction(Desc *descriptor, unsigned int startElement = UINT32_MAX);
+    // Prepare every group of a transaction spanning several vectors, then insert all of them and commit.
+    // Elements only go in once every group is prepared, so anyone who finds one can finish the whole transaction.
+    static void executeGroups(std::vector<Desc *> *groups);
+    // Run a transaction, without announcing it first.
+    void runTransaction(Desc *descriptor);
+    // Hand a transaction to the log or the elimination array, or announce it if need be and run it.
+    // Called inside an epoch guard.
+    void submitTransaction(Desc *descriptor);
+    // Where lone pushes and pops meet to cancel out.
+    EliminationArray elimination;
+    // Check if a transaction of a single push or pop may cancel out against an opposite one, rather than wait on size.
+    bool eliminable(Desc *descriptor);
 
 public:
     // A page holding our shared size variable.
@@ -56,6 +81,16 @@ public:
     std::atomic<CompactElement> size;
     // Default constructor.
     CompactVector();
+    // The log push-only transactions append to in log mode, or NULL for a plain vector.
+    AppendLog *log = NULL;
+    // Switch to log mode, where the vector only takes push-only transactions.
+    // Only call before any transaction runs.
+    void makeLog();
+    // Fill an empty vector without running transactions, writing elements straight into the array.
+    // Only valid before any transaction runs, and before any other thread has the vector.
+    // threads: The number of threads that write elements, each for its own range of them.
+    // Returns false if the vector isn't empty, or the values don't fit.
+    bool bulkLoad(const VAL *values, size_t count, unsigned int threads);
     // Apply a transaction to a vector.
     void executeTransaction(Desc *descriptor);
     // Called if a transaction is blocking on size.
@@ -65,4 +100,7 @@ public:
 };
 
 #endif
+
+END_ENGINE_NAMESPACE
+
 #endif
\ No newline at end of file
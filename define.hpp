@@ -1,6 +1,8 @@
 #ifndef DEFINE_HPP
 #define DEFINE_HPP
 
+#include <cstdint>
+
 // These are used to switch between different vector implementations.
 // Only uncomment one of them at a time. **Make sure they're all commented if using the test-all.sh script**
 // **It's important to keep these comments as "//#define" instead of "// define"**
@@ -11,6 +13,33 @@
 //#define STMVEC
 //#define STOVEC
 
+// Each engine's code lives in a namespace of its own, so several engines can be linked into one binary.
+// Code shared by every engine (operations, regions, the thread registry, and engine.hpp) stays outside of them.
+#if defined(SEGMENTVEC)
+#define ENGINE_NAME "SEGMENTVEC"
+#define ENGINE_NAMESPACE segmentvec
+#elif defined(COMPACTVEC)
+#define ENGINE_NAME "COMPACTVEC"
+#define ENGINE_NAMESPACE compactvec
+#elif defined(BOOSTEDVEC)
+#define ENGINE_NAME "BOOSTEDVEC"
+#define ENGINE_NAMESPACE boostedvec
+#elif defined(COARSEVEC)
+#define ENGINE_NAME "COARSEVEC"
+#define ENGINE_NAMESPACE coarsevec
+#elif defined(STMVEC)
+#define ENGINE_NAME "STMVEC"
+#define ENGINE_NAMESPACE stmvec
+#elif defined(STOVEC)
+#define ENGINE_NAME "STOVEC"
+#define ENGINE_NAMESPACE stovec
+#else
+#define ENGINE_NAME "NONE"
+#define ENGINE_NAMESPACE noengine
+#endif
+#define BEGIN_ENGINE_NAMESPACE namespace ENGINE_NAMESPACE {
+#define END_ENGINE_NAMESPACE }
+
 // Change these to test different situations.
 // Makes sense to make this cache line size X associativity (perhaps at L2 level, so 8*16)
 // Divide by the size of the elements in the segment an by 2, so we can hold old and new values on the same cache line.
@@ -21,8 +50,53 @@
 //#define TRANSACTION_SIZE 5
 // Define this to enable the helping scheme.
 #define HELP
+#ifdef HELP
+// Define this to make the lock-free vectors wait-free.
+// Transactions announce themselves, and every thread helps the older announced transactions before running its own.
+// Long transactions then finish within a bounded number of steps, however many short ones arrive behind them.
+//#define WAIT_FREE
+// The number of threads that can announce transactions at once. Threads with a higher registry slot run lock-free.
+// TUNE
+#define ANNOUNCE_SLOTS 256
+#endif
 // Define this to debug allocation counting.
 //#define ALLOC_COUNT
+// The number of free objects each thread caches per type before sharing them with other threads.
+// TUNE
+#define MAGAZINE_SIZE 64
+// The largest slab, in magazines, a thread allocates at once when no thread has objects to spare.
+#define MAX_SLAB_MAGAZINES 64
+// Define this to back the preallocated object slabs with transparent huge pages.
+//#define HUGE_PAGES
+// Define this to have each worker thread build its own share of the preallocated objects when it starts.
+// Keeps each thread's objects on its own NUMA node. Otherwise, allocatorInit builds the shares it reserves up front.
+// Off by default, since the test cases start workers inside their timed section and would time the faulting too.
+//#define FIRST_TOUCH
+// The bytes in each chunk of a region, the arenas that read/write sets build their maps in.
+// Retired sets hand their chunks back for reuse, so this only needs to fit a typical set.
+// TUNE
+#define REGION_CHUNK_SIZE (16 * 1024)
+// The number of objects a thread retires before it tries to reclaim those no other thread can reach anymore.
+// TUNE
+#define EPOCH_BATCH 64
+// The number of readers each element location stores inline before allocating.
+// TUNE
+#define READ_LIST_SIZE 2
+// Retry backoffs shorter than this many nanoseconds yield in a loop instead of sleeping, since a sleep overshoots them by far.
+// TUNE
+#define RETRY_SPIN_NS 50000
+// The number of positions in the first bucket of an append-only log. Each bucket after it doubles. Must be a power of 2.
+// TUNE
+#define LOG_FIRST_BUCKET 1024
+// The number of buckets an append-only log can grow to.
+// TUNE
+#define LOG_BUCKETS 32
+// The number of slots where lone pushes and pops on a compact vector wait for an opposite partner while size is busy.
+// TUNE
+#define ELIMINATION_SLOTS 4
+// How many times a waiting push or pop checks its slot for a partner before going on to size.
+// TUNE
+#define ELIMINATION_SPINS 512
 // Define this to optimize traversal order.
 #define HIGHTOLOW
 // Define this to capture performance metrics (average transaction times)
@@ -33,6 +107,10 @@
 //#define ALIGNED
 // Enable conflict-free reads and their associated (essentially non-existant) overhead.
 #define CONFLICT_FREE_READS
+// The number of element locations a RWSet holds inline before spilling into a hashed map.
+// Most transactions touch fewer locations than this, so they never allocate map nodes.
+// TUNE
+#define FLAT_RWSET_SIZE 16
 #endif
 
 // Compact vector requires 32-bit or smaller value types.
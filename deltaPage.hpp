@@ -11,8 +11,11 @@
 
 #include "allocator.hpp"
 #include "define.hpp"
+#include "operation.hpp"
 #include "transaction.hpp"
 
+BEGIN_ENGINE_NAMESPACE
+
 #define NEW_VAL 1
 #define OLD_VAL 0
 
@@ -26,6 +29,12 @@ struct Bitset
 	std::bitset<size> read;
 	std::bitset<size> write;
 	std::bitset<size> checkBounds;
+	// Set where a compare write checks the old value before writing.
+	std::bitset<size> compare;
+	// Set where a commutative update is combined with the value below, instead of replacing it.
+	std::bitset<size> delta;
+	// Set where an update needs the value below after all, to check that its result is not UNSET.
+	std::bitset<size> checkDelta;
 };
 
 // A delta update page.
@@ -43,6 +52,11 @@ private:
 	// A contiguous list of old values.
 	// We need these in case the associated transaction aborts.
 	T oldVal[S];
+	// The type of each commutative update, whose operand is stored as the new value.
+	// Stored as bytes to keep pages small.
+	unsigned char deltaTypes[S];
+	// The page helpers copied this one from, or NULL if this is the original.
+	Page *origin = NULL;
 	// Get the new or old value at the given index for the current page.
 	T *at(size_t index, bool newVals)
 	{
@@ -51,9 +65,9 @@ private:
 		{
 			return NULL;
 		}
-		// Used bits are any locations that are read from or written to.
+		// Used bits are any locations that are read from, written to, or updated.
 		std::bitset<Page<T, S>::SEG_SIZE> usedBits =
-			Page::bitset.read | Page::bitset.write;
+			Page::bitset.read | Page::bitset.write | Page::bitset.delta;
 		// If the bit isn't even in this page, we can't return a valid value.
 		if (usedBits[index] != 1)
 		{
@@ -82,6 +96,7 @@ public:
 			// This is not an issue because size pages are set to 0 after initialization.
 			newVal[i] = UNSET;
 			oldVal[i] = UNSET;
+			deltaTypes[i] = 0;
 		}
 		return;
 	}
@@ -93,6 +108,9 @@ public:
 	Desc *transaction = NULL;
 	// A pointer to the next page in the update list for this segment.
 	Page *next = NULL;
+	// Set on the original page once it, or any copy of it, is in the vector.
+	// Updates are not idempotent, so helpers check this rather than risk inserting a page twice.
+	std::atomic<bool> installed{false};
 
 	// Read the element from the page.
 	bool get(size_t index, bool newVals, T &val)
@@ -117,18 +135,41 @@ public:
 		return true;
 	}
 
+	// Store a commutative update for an element.
+	void setDelta(size_t index, Operation::OpType type, T operand)
+	{
+		deltaTypes[index] = (unsigned char)type;
+		newVal[index] = operand;
+		return;
+	}
+	// Get the type of an element's commutative update.
+	Operation::OpType deltaType(size_t index) const
+	{
+		return (Operation::OpType)deltaTypes[index];
+	}
+	// Get the page this one was copied from, or this page if it is the original.
+	Page *original()
+	{
+		return origin == NULL ? this : origin;
+	}
+
 	// Copy some of the values from one page into this one.
 	bool copyFrom(Page *page)
 	{
 		this->bitset.read = page->bitset.read;
 		this->bitset.write = page->bitset.write;
 		this->bitset.checkBounds = page->bitset.checkBounds;
+		this->bitset.compare = page->bitset.compare;
+		this->bitset.delta = page->bitset.delta;
+		this->bitset.checkDelta = page->bitset.checkDelta;
 		this->transaction = page->transaction;
+		this->origin = page->original();
 		// This will be set later. No need to copy it.
 		//next = page->next;
 		for (size_t i = 0; i < page->SEG_SIZE; i++)
 		{
 			this->newVal[i] = page->newVal[i];
+			this->deltaTypes[i] = page->deltaTypes[i];
 			// This will be set later. No need to copy it.
 			//this->oldVal[i] = page->oldVal[i];
 		}
@@ -143,6 +184,8 @@ public:
 		std::cout << "read \t\t= " << bitset.read.to_string() << std::endl;
 		std::cout << "write \t\t= " << bitset.write.to_string() << std::endl;
 		std::cout << "checkBounds \t= " << bitset.checkBounds.to_string() << std::endl;
+		std::cout << "compare \t= " << bitset.compare.to_string() << std::endl;
+		std::cout << "delta \t\t= " << bitset.delta.to_string() << std::endl;
 		std::cout << "transaction \t= " << transaction << std::endl;
 		std::cout << "next \t\t= " << next << std::endl;
 		for (size_t i = 0; i < this->SEG_SIZE; i++)
@@ -154,4 +197,6 @@ public:
 	}
 };
 
+END_ENGINE_NAMESPACE
+
 #endif
\ No newline at end of file
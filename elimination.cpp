@@ -0,0 +1,92 @@
+#include <random>
+#include <thread>
+
+#include "elimination.hpp"
+#include "transaction.hpp"
+
+BEGIN_ENGINE_NAMESPACE
+
+#ifdef COMPACTVEC
+
+// A value must fit in the high half of a slot.
+static_assert(sizeof(VAL) <= sizeof(uint32_t), "Elimination slots pack a value into 32 bits.");
+
+EliminationArray::EliminationArray()
+{
+	for (size_t i = 0; i < ELIMINATION_SLOTS; i++)
+	{
+		slots[i].store(EMPTY);
+	}
+	return;
+}
+
+bool EliminationArray::exchange(Desc *descriptor)
+{
+#ifdef METRICS
+	descriptor->startTime = std::chrono::high_resolution_clock::now();
+#endif
+	Operation *op = &descriptor->ops[0];
+	bool push = op->type == Operation::OpType::pushBack;
+	// A push offers its value, and a pop has none to offer.
+	uint64_t offer = push ? ((uint64_t)op->val << 32) | PUSH : POP;
+	uint64_t partner = push ? POP : PUSH;
+	// Spread threads over the slots, so pairs don't pile onto one.
+	static thread_local std::minstd_rand random(std::hash<std::thread::id>()(std::this_thread::get_id()));
+	std::atomic<uint64_t> &slot = slots[random() % ELIMINATION_SLOTS];
+
+	uint64_t found = slot.load();
+	if ((found & KIND) == partner)
+	{
+		// Take the waiting partner's offer, and leave a push's value for a waiting pop.
+		if (!slot.compare_exchange_strong(found, (offer & ~KIND) | TAKEN))
+		{
+			return false;
+		}
+		if (!push)
+		{
+			op->ret = (VAL)(found >> 32);
+		}
+	}
+	else if (found == EMPTY)
+	{
+		if (!slot.compare_exchange_strong(found, offer))
+		{
+			return false;
+		}
+		for (size_t i = 0; i < ELIMINATION_SPINS && (found & KIND) != TAKEN; i++)
+		{
+			found = slot.load();
+		}
+		if ((found & KIND) != TAKEN)
+		{
+			// Withdraw the offer, unless a partner takes it first.
+			found = offer;
+			if (slot.compare_exchange_strong(found, EMPTY))
+			{
+				return false;
+			}
+		}
+		// Only the waiting thread empties a taken slot, once it has its answer.
+		if (!push)
+		{
+			op->ret = (VAL)(found >> 32);
+		}
+		slot.store(EMPTY);
+	}
+	else
+	{
+		// The slot holds an offer like ours, or an answer not yet collected.
+		return false;
+	}
+#ifdef METRICS
+	// Eliminated transactions don't use pre-processing.
+	descriptor->preprocessTime = descriptor->startTime;
+	descriptor->endTime = std::chrono::high_resolution_clock::now();
+#endif
+	descriptor->status.store(Desc::TxStatus::committed);
+	return true;
+}
+
+#endif
+
+END_ENGINE_NAMESPACE
@@ -0,0 +1,46 @@
+/*
+This file holds the elimination array of the compact vector.
+A push and a pop running at the same time cancel out, since the pop can return the pushed value with size left as it was.
+While size is busy, a lone push or pop waits briefly in a random slot for an opposite partner, and the two exchange the value there without touching size.
+*/
+#ifndef ELIMINATION_HPP
+#define ELIMINATION_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "define.hpp"
+
+BEGIN_ENGINE_NAMESPACE
+
+// Only the compact vector updates size with a single wide CAS every push and pop contends on.
+#ifdef COMPACTVEC
+
+struct Desc;
+
+class EliminationArray
+{
+private:
+	// Each slot is empty, holds a waiting push or pop, or holds the answer left for one.
+	// The low bits say which, and the high half carries the value pushed, so no thread ever reads another's descriptor.
+	static const uint64_t EMPTY = 0;
+	static const uint64_t TAKEN = 1;
+	static const uint64_t PUSH = 2;
+	static const uint64_t POP = 4;
+	static const uint64_t KIND = 7;
+	std::atomic<uint64_t> slots[ELIMINATION_SLOTS];
+
+public:
+	EliminationArray();
+
+	// Try to cancel out a transaction of a single push or pop against an opposite one.
+	// Returns true if it found a partner and committed. Otherwise nothing changed, and it must run as usual.
+	bool exchange(Desc *descriptor);
+};
+
+#endif
+
+END_ENGINE_NAMESPACE
+
+#endif
@@ -0,0 +1,76 @@
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+#include "engine.hpp"
+
+// Registrars run during static initialization, in no particular order, so the registry is built on first use.
+static std::vector<std::pair<const char *, EngineFactory>> &registry()
+{
+	static std::vector<std::pair<const char *, EngineFactory>> engines;
+	return engines;
+}
+
+EngineRegistrar::EngineRegistrar(const char *name, EngineFactory factory)
+{
+	registry().push_back(std::make_pair(name, factory));
+}
+
+Engine *createEngine(const char *name)
+{
+	for (auto &engine : registry())
+	{
+		if (strcmp(engine.first, name) == 0)
+		{
+			return engine.second();
+		}
+	}
+	return NULL;
+}
+
+bool Engine::bulkLoadFile(const char *path, unsigned int threads)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size % sizeof(VAL) != 0)
+	{
+		close(fd);
+		return false;
+	}
+	size_t bytes = info.st_size;
+	// An empty file maps nothing, and loads nothing.
+	if (bytes == 0)
+	{
+		close(fd);
+		return bulkLoad(NULL, 0, threads);
+	}
+	void *mapped = mmap(NULL, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping holds its own reference to the file.
+	close(fd);
+	if (mapped == MAP_FAILED)
+	{
+		return false;
+	}
+	// Each loading thread reads its share front to back.
+	madvise(mapped, bytes, MADV_SEQUENTIAL);
+	bool loaded = bulkLoad((const VAL *)mapped, bytes / sizeof(VAL), threads);
+	munmap(mapped, bytes);
+	return loaded;
+}
+
+std::vector<const char *> engineNames()
+{
+	std::vector<const char *> names;
+	for (auto &engine : registry())
+	{
+		names.push_back(engine.first);
+	}
+	return names;
+}
@@ -0,0 +1,99 @@
+/*
+This file holds the interface that picks a vector engine at runtime.
+Each engine built into the binary registers itself under its name, so a benchmark or application can compare engines without being rebuilt.
+*/
+#ifndef ENGINE_HPP
+#define ENGINE_HPP
+
+#include <functional>
+#include <vector>
+
+#include "define.hpp"
+#include "memoryStats.hpp"
+#include "operation.hpp"
+#include "parallelFor.hpp"
+#include "retryPolicy.hpp"
+
+// A transactional vector, hiding which engine implements it.
+class Engine
+{
+public:
+	virtual ~Engine() {}
+	// Get the name the engine registered under.
+	virtual const char *name() const = 0;
+	// Run a transaction against the vector.
+	// ops:     The operations of the transaction. Their return values are filled in if it commits.
+	// size:    The number of operations.
+	// cause:   If not NULL, gets why the transaction aborted, or none if it committed.
+	// Returns true if the transaction committed.
+	virtual bool execute(Operation *ops, unsigned int size, AbortCause *cause = NULL) = 0;
+	// Run a transaction, running it again after each abort the policy retries.
+	// Lock-based engines rerun the same descriptor on the caller's operations, so no attempt allocates.
+	// SEGMENTVEC and COMPACTVEC allocate a descriptor and a copy of the operations for every attempt.
+	// The copy is reclaimed, but the descriptor never is, since the pages or elements it wrote keep pointing at it.
+	// cause:   If not NULL, gets why the last attempt aborted, or none if the transaction committed.
+	// Returns true if some attempt committed.
+	virtual bool execute(Operation *ops, unsigned int size, const RetryPolicy &policy, AbortCause *cause = NULL) = 0;
+	// Replace the vector with an empty deque, which supports pushFront and popFront.
+	// Only call before any transaction runs.
+	// capacity:    The most elements the deque holds, rounded up to a power of 2.
+	// Returns false if the engine has no deque mode.
+	virtual bool makeDeque(size_t capacity) = 0;
+	// Make the vector an append-only log, which only takes transactions that do nothing but push.
+	// Appends reserve their positions without contending on size, and aborted ones leave tombstones that readers skip.
+	// Only call before any transaction runs.
+	// Returns false if the engine has no log mode.
+	virtual bool makeLog() = 0;
+	// Copy out the values appended to a log, in order.
+	// cursor:  The position to read from. Start at 0, and pass the cursor left by the last call to continue.
+	// out:     Gets up to max values.
+	// Returns the number of values copied. Stops early at the first append still in progress.
+	virtual size_t readLog(size_t &cursor, VAL *out, size_t max) = 0;
+	// Fill an empty vector directly, without running transactions, which is far faster than pushing the values.
+	// Only call before any transaction runs, and before any other thread has the vector.
+	// values:  The elements, in order.
+	// threads: The number of threads that fill the vector, each writing its own share.
+	// Returns false if the engine can't bulk load, the vector isn't empty, or the values don't fit.
+	virtual bool bulkLoad(const VAL *values, size_t count, unsigned int threads = THREAD_COUNT) = 0;
+	// Bulk load the values stored in a file, raw and in native byte order.
+	// The file is mapped rather than read, so the values are copied straight from the page cache.
+	// Returns false if the file can't be mapped, its size isn't a whole number of values, or bulkLoad fails.
+	bool bulkLoadFile(const char *path, unsigned int threads = THREAD_COUNT);
+	// Reduce a version-consistent snapshot of the vector, without running a transaction or blocking writers.
+	// The snapshot's pages are split between threads, which each fold their own.
+	// result:  Gets the reduction. Elements without a value are left out.
+	// Returns false if the engine has no consistent snapshots.
+	virtual bool reduce(Reduction reduction, uint64_t &result, unsigned int threads = THREAD_COUNT) = 0;
+	// Count the elements of a version-consistent snapshot for which predicate returns true, same as reduce.
+	// predicate: Called from several threads at once. Elements without a value are left out.
+	// Returns false if the engine has no consistent snapshots.
+	virtual bool countIf(const std::function<bool(VAL value)> &predicate, uint64_t &result, unsigned int threads = THREAD_COUNT) = 0;
+	// Call body(first, values, count) on every element of a version-consistent snapshot, in runs of consecutive indexes starting at first.
+	// Runs are passed on from several threads at once, in no particular order.
+	// Returns false if the engine has no consistent snapshots.
+	virtual bool forEach(const std::function<void(size_t first, const VAL *values, size_t count)> &body, unsigned int threads = THREAD_COUNT) = 0;
+	// Prepare the calling thread to run transactions. Call before a thread's first execute.
+	virtual void threadInit() = 0;
+	// Release what the calling thread holds. Call once a thread is done running transactions.
+	virtual void threadFinish() = 0;
+	// Get a snapshot of the engine's memory use.
+	virtual std::vector<MemoryStats> memoryStats() = 0;
+};
+
+// Builds a fresh vector of one engine.
+typedef Engine *(*EngineFactory)();
+
+// Registers an engine when constructed. Each engine's sources hold a static one.
+struct EngineRegistrar
+{
+	EngineRegistrar(const char *name, EngineFactory factory);
+};
+
+// Build a vector of the named engine.
+// Returns NULL if that engine is not built into this binary.
+Engine *createEngine(const char *name);
+
+// Get the names of the engines built into this binary.
+std::vector<const char *> engineNames();
+
+#endif
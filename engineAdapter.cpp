@@ -0,0 +1,282 @@
+// This file registers the engine it is compiled for with the runtime engine registry.
+// Build it once per engine, with that engine defined.
+
+#include <cstring>
+#include <mutex>
+
+#include "allocator.hpp"
+#include "engine.hpp"
+#include "epoch.hpp"
+#include "transaction.hpp"
+
+#ifdef SEGMENTVEC
+#include "transVector.hpp"
+#endif
+#ifdef COMPACTVEC
+#include "compactVector.hpp"
+#endif
+#ifdef BOOSTEDVEC
+#include "boostedVector.hpp"
+#endif
+#if defined(STMVEC) || defined(COARSEVEC)
+#include "vector.hpp"
+#endif
+#ifdef STOVEC
+#include "STOVec.hpp"
+#endif
+
+BEGIN_ENGINE_NAMESPACE
+
+#if defined(SEGMENTVEC) || defined(COMPACTVEC) || defined(BOOSTEDVEC) || defined(STMVEC) || defined(COARSEVEC) || defined(STOVEC)
+
+#ifdef SEGMENTVEC
+typedef TransactionalVector EngineVector;
+#endif
+#ifdef COMPACTVEC
+typedef CompactVector EngineVector;
+#endif
+#ifdef BOOSTEDVEC
+typedef BoostedVector EngineVector;
+#endif
+#ifdef STMVEC
+typedef GCCSTMVector EngineVector;
+#endif
+#ifdef COARSEVEC
+typedef CoarseTransVector EngineVector;
+#endif
+#ifdef STOVEC
+typedef STOVector EngineVector;
+#endif
+
+#if defined(SEGMENTVEC) || defined(COMPACTVEC)
+// Free the operations an attempt ran on.
+static void reclaimCopies(void *copies)
+{
+	delete[] (Operation *)copies;
+	return;
+}
+#endif
+
+class VectorEngine : public Engine
+{
+private:
+	EngineVector *vector;
+
+public:
+	VectorEngine()
+	{
+		// The allocators are shared by every vector of this engine, so they are only set up once.
+		// An engine does not know its workload, so nothing is reserved and its threads grow the allocators as they go.
+		static std::once_flag allocatorsReady;
+		std::call_once(allocatorsReady, [] { allocatorInit(); });
+		vector = new EngineVector();
+	}
+
+	const char *name() const
+	{
+		return ENGINE_NAME;
+	}
+
+	bool execute(Operation *ops, unsigned int size, AbortCause *cause)
+	{
+		return execute(ops, size, RetryPolicy(1), cause);
+	}
+
+	bool execute(Operation *ops, unsigned int size, const RetryPolicy &policy, AbortCause *cause)
+	{
+#if defined(BOOSTEDVEC) || defined(STMVEC) || defined(COARSEVEC) || defined(STOVEC)
+		// Lock-based engines are done with a descriptor once it returns, so it runs on the caller's operations in place.
+		// Every retry resets and reruns the same one.
+		Desc desc(size, ops);
+#else
+		// Allocation-free submission does not cover the lock-free engines.
+		// They leave a descriptor referenced from the pages or elements it wrote, for as long as those last, so each attempt allocates one that is never freed.
+		// Helpers may still write results into its operations after it finishes, so each attempt runs on copies of its own.
+		// They are reclaimed once every helper that could reach them is done.
+		Desc *desc = NULL;
+		Operation *copies = NULL;
+#endif
+		bool committed;
+		for (unsigned int attempt = 1;; attempt++)
+		{
+#if defined(BOOSTEDVEC) || defined(STMVEC) || defined(COARSEVEC) || defined(STOVEC)
+#ifdef BOOSTEDVEC
+			committed = vector->executeTransaction(&desc);
+#else
+			vector->executeTransaction(&desc);
+			committed = desc.status.load() == Desc::TxStatus::committed;
+#endif
+			AbortCause last = committed ? AbortCause::none : desc.abortCause.load();
+#else
+			copies = new Operation[size];
+			memcpy(copies, ops, size * sizeof(Operation));
+			desc = new Desc(size, copies);
+			// The vector runs every transaction inside an epoch guard, since any thread running one may help this one.
+			vector->executeTransaction(desc);
+			committed = desc->status.load() == Desc::TxStatus::committed;
+			AbortCause last = committed ? AbortCause::none : desc->abortCause.load();
+#endif
+			if (committed || !policy.shouldRetry(last, attempt))
+			{
+				if (cause != NULL)
+				{
+					*cause = last;
+				}
+				break;
+			}
+#if defined(BOOSTEDVEC) || defined(STMVEC) || defined(COARSEVEC) || defined(STOVEC)
+			policy.wait(attempt);
+			desc.reset();
+#else
+			// The aborted attempt's copies are out of reach the same way as the last attempt's.
+			Epoch::retire(copies, reclaimCopies);
+			policy.wait(attempt);
+#endif
+		}
+#if defined(BOOSTEDVEC) || defined(STMVEC) || defined(COARSEVEC) || defined(STOVEC)
+		return committed;
+#else
+		// Helpers only touch the operations of active transactions, so no thread entering a guard from now on reaches these.
+		if (!committed)
+		{
+			Epoch::retire(copies, reclaimCopies);
+			return false;
+		}
+		for (unsigned int i = 0; i < size; i++)
+		{
+			ops[i].ret = copies[i].ret;
+			// Size results go in index.
+			ops[i].index = copies[i].index;
+		}
+		Epoch::retire(copies, reclaimCopies);
+		return true;
+#endif
+	}
+
+	bool makeDeque(size_t capacity)
+	{
+#if defined(COMPACTVEC) || defined(STOVEC)
+		// Compact elements and STO's version tables have no front to wrap around.
+		(void)capacity;
+		return false;
+#else
+		// No transaction has run yet, so nothing else references the old vector.
+		delete vector;
+		vector = new EngineVector(capacity);
+		return true;
+#endif
+	}
+
+	bool makeLog()
+	{
+#if defined(SEGMENTVEC) || defined(COMPACTVEC)
+		vector->makeLog();
+		return true;
+#else
+		// Locks already serialize pushes, so there is nothing for a log to save.
+		return false;
+#endif
+	}
+
+	size_t readLog(size_t &cursor, VAL *out, size_t max)
+	{
+#if defined(SEGMENTVEC) || defined(COMPACTVEC)
+		if (vector->log != NULL)
+		{
+			return vector->log->read(cursor, out, max);
+		}
+#endif
+		(void)cursor;
+		(void)out;
+		(void)max;
+		return 0;
+	}
+
+	bool bulkLoad(const VAL *values, size_t count, unsigned int threads)
+	{
+#ifdef STOVEC
+		// STO's vector only takes values through its own transactions.
+		(void)values;
+		(void)count;
+		(void)threads;
+		return false;
+#else
+		return vector->bulkLoad(values, count, threads);
+#endif
+	}
+
+	bool reduce(Reduction reduction, uint64_t &result, unsigned int threads)
+	{
+#if defined(SEGMENTVEC) && defined(CONFLICT_FREE_READS)
+		result = vector->parallelReduce(vector->snapshot(), reduction, threads);
+		return true;
+#else
+		// Only the segmented vector keeps the versions a snapshot needs.
+		(void)reduction;
+		(void)result;
+		(void)threads;
+		return false;
+#endif
+	}
+
+	bool countIf(const std::function<bool(VAL value)> &predicate, uint64_t &result, unsigned int threads)
+	{
+#if defined(SEGMENTVEC) && defined(CONFLICT_FREE_READS)
+		auto fold = [&predicate](uint64_t partial, const VAL *values, size_t count) {
+			for (size_t i = 0; i < count; i++)
+			{
+				partial += values[i] != UNSET && predicate(values[i]);
+			}
+			return partial;
+		};
+		auto combine = [](uint64_t a, uint64_t b) {
+			return a + b;
+		};
+		result = vector->parallelReduce(vector->snapshot(), (uint64_t)0, fold, combine, threads);
+		return true;
+#else
+		(void)predicate;
+		(void)result;
+		(void)threads;
+		return false;
+#endif
+	}
+
+	bool forEach(const std::function<void(size_t first, const VAL *values, size_t count)> &body, unsigned int threads)
+	{
+#if defined(SEGMENTVEC) && defined(CONFLICT_FREE_READS)
+		vector->parallelForEach(vector->snapshot(), body, threads);
+		return true;
+#else
+		(void)body;
+		(void)threads;
+		return false;
+#endif
+	}
+
+	void threadInit()
+	{
+		threadAllocatorInit();
+	}
+
+	void threadFinish()
+	{
+		threadAllocatorFinish();
+	}
+
+	std::vector<MemoryStats> memoryStats()
+	{
+		return ENGINE_NAMESPACE::memoryStats();
+	}
+};
+
+static Engine *createVectorEngine()
+{
+	return new VectorEngine();
+}
+
+static EngineRegistrar registrar(ENGINE_NAME, createVectorEngine);
+
+#endif
+
+END_ENGINE_NAMESPACE
@@ -0,0 +1,140 @@
+#include "epoch.hpp"
+
+std::atomic<uint64_t> Epoch::global(0);
+
+std::atomic<Epoch::Record *> Epoch::records(NULL);
+
+std::vector<Epoch::Retired> Epoch::orphans;
+
+std::mutex Epoch::orphansLock;
+
+thread_local Epoch::Record *Epoch::record = NULL;
+
+thread_local size_t Epoch::depth = 0;
+
+thread_local std::vector<Epoch::Retired> Epoch::limbo;
+
+void Epoch::acquire()
+{
+    for (Record *current = records.load(); current != NULL; current = current->next)
+    {
+        bool taken = false;
+        if (!current->taken.load() && current->taken.compare_exchange_strong(taken, true))
+        {
+            record = current;
+            return;
+        }
+    }
+    record = new Record();
+    record->announced.store(QUIESCENT);
+    record->taken.store(true);
+    Record *head = records.load();
+    do
+    {
+        record->next = head;
+    } while (!records.compare_exchange_weak(head, record));
+    return;
+}
+
+void Epoch::advance()
+{
+    uint64_t current = global.load();
+    for (Record *other = records.load(); other != NULL; other = other->next)
+    {
+        uint64_t announced = other->announced.load();
+        if (announced != QUIESCENT && announced != current)
+        {
+            return;
+        }
+    }
+    // Fails only if another thread already moved it on.
+    global.compare_exchange_strong(current, current + 1);
+    return;
+}
+
+void Epoch::enter()
+{
+    if (depth++ != 0)
+    {
+        return;
+    }
+    if (record == NULL)
+    {
+        acquire();
+    }
+    // The epoch may move on between reading and announcing it, so only an announcement still current counts.
+    uint64_t current = 0;
+    do
+    {
+        current = global.load();
+        record->announced.store(current);
+    } while (global.load() != current);
+    return;
+}
+
+void Epoch::exit()
+{
+    if (--depth == 0)
+    {
+        record->announced.store(QUIESCENT);
+    }
+    return;
+}
+
+void Epoch::retire(void *object, void (*reclaim)(void *))
+{
+    limbo.push_back({global.load(), object, reclaim});
+    if (limbo.size() >= EPOCH_BATCH)
+    {
+        collect();
+    }
+    return;
+}
+
+void Epoch::collect()
+{
+    // Take over what finished threads left behind, unless another thread already is.
+    if (orphansLock.try_lock())
+    {
+        limbo.insert(limbo.end(), orphans.begin(), orphans.end());
+        orphans.clear();
+        orphansLock.unlock();
+    }
+    advance();
+    // A thread that could still reach the memory announced the epoch it was retired in, at the latest.
+    // The epoch only moves two past that once the thread leaves its guard.
+    uint64_t current = global.load();
+    size_t kept = 0;
+    for (size_t i = 0; i < limbo.size(); i++)
+    {
+        if (limbo[i].epoch + 2 <= current)
+        {
+            limbo[i].reclaim(limbo[i].object);
+        }
+        else
+        {
+            limbo[kept++] = limbo[i];
+        }
+    }
+    limbo.resize(kept);
+    return;
+}
+
+void Epoch::threadFinish()
+{
+    collect();
+    if (!limbo.empty())
+    {
+        std::lock_guard<std::mutex> guard(orphansLock);
+        orphans.insert(orphans.end(), limbo.begin(), limbo.end());
+        limbo.clear();
+    }
+    if (record != NULL)
+    {
+        record->announced.store(QUIESCENT);
+        record->taken.store(false);
+        record = NULL;
+    }
+    depth = 0;
+    return;
+}
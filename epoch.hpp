@@ -0,0 +1,90 @@
+/*
+This file holds epoch-based reclamation, for memory other threads may still be using when its owner is done with it.
+Threads reach shared memory inside an EpochGuard. Memory retired while a thread is inside one is only reclaimed after that thread leaves it.
+*/
+#ifndef EPOCH_HPP
+#define EPOCH_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "define.hpp"
+
+class Epoch
+{
+private:
+    // Publishes the epoch a thread is in to the threads reclaiming memory.
+    struct Record
+    {
+        // The epoch the thread entered its guard in, or QUIESCENT outside of any guard.
+        std::atomic<uint64_t> announced;
+        // Set while a thread owns the record. Records of finished threads go to the next thread that needs one.
+        std::atomic<bool> taken;
+        // Links every record. Records are never freed.
+        Record *next;
+    };
+    // Memory waiting for every thread that could still reach it to leave its guard.
+    struct Retired
+    {
+        // The epoch the memory was retired in.
+        uint64_t epoch;
+        void *object;
+        void (*reclaim)(void *);
+    };
+
+    static const uint64_t QUIESCENT = UINT64_MAX;
+
+    static std::atomic<uint64_t> global;
+    static std::atomic<Record *> records;
+    // Memory retired by finished threads, waiting for a thread still running to reclaim it.
+    static std::vector<Retired> orphans;
+    static std::mutex orphansLock;
+    // The calling thread's record, taken on its first guard.
+    thread_local static Record *record;
+    // Guards nest, and only the outermost one announces an epoch.
+    thread_local static size_t depth;
+    // Memory retired by the calling thread.
+    thread_local static std::vector<Retired> limbo;
+
+    // Take over a free record, or add one.
+    static void acquire();
+    // Move the global epoch on, if every thread inside a guard already announced it.
+    static void advance();
+
+public:
+    // Enter a guard. Memory the calling thread reaches from here on stays valid until the matching exit.
+    static void enter();
+    // Leave a guard.
+    static void exit();
+    // Reclaim memory once no thread inside a guard can still reach it.
+    // Only call this once the memory is out of reach for threads entering a guard from now on.
+    // reclaim:    Called with object to free it, on whichever thread reclaims it.
+    static void retire(void *object, void (*reclaim)(void *));
+    // Reclaim whatever the calling thread retired that is now out of every thread's reach.
+    // Called every EPOCH_BATCH retires, so this is only needed to reclaim sooner.
+    static void collect();
+    // Give up the calling thread's record before the thread exits.
+    // Memory it retired that is still reachable is left to the threads that keep running.
+    static void threadFinish();
+};
+
+// Keeps the calling thread inside a guard while in scope.
+class EpochGuard
+{
+public:
+    EpochGuard()
+    {
+        Epoch::enter();
+    }
+    EpochGuard(const EpochGuard &) = delete;
+    EpochGuard &operator=(const EpochGuard &) = delete;
+    ~EpochGuard()
+    {
+        Epoch::exit();
+    }
+};
+
+#endif
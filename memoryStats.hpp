@@ -0,0 +1,39 @@
+#ifndef MEMORYSTATS_HPP
+#define MEMORYSTATS_HPP
+
+#include <atomic>
+#include <cstddef>
+
+// A snapshot of the memory used by one pool.
+// Always available, since every counter behind it only changes a magazine or chunk at a time.
+struct MemoryStats
+{
+    // What the pool holds.
+    const char *name = NULL;
+    // The size of each object, or 1 for pools of raw bytes.
+    size_t objectSize = 0;
+    // Bytes taken from the system, whether or not anything lives there yet.
+    size_t reservedBytes = 0;
+    // Bytes handed out to threads.
+    // Counted a magazine or chunk at a time, so free space a thread has cached counts as in use.
+    size_t inUseBytes = 0;
+    // The most bytes ever in use at once.
+    size_t highWaterBytes = 0;
+    // Allocations from the system after the preallocated memory ran out. Growing steadily means init was sized too small.
+    size_t fallbackAllocations = 0;
+    // Bytes in use by things that are no longer needed but cannot be reclaimed, such as superseded delta pages.
+    size_t retiredBytes = 0;
+};
+
+// Raise a high-water mark to at least value.
+inline void raiseHighWater(std::atomic<size_t> &highWater, size_t value)
+{
+    size_t current = highWater.load(std::memory_order_relaxed);
+    while (current < value && !highWater.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+        continue;
+    }
+    return;
+}
+
+#endif
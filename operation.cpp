@@ -0,0 +1,62 @@
+#include <iostream>
+
+#include "operation.hpp"
+
+void Operation::print()
+{
+	const char *typeStrList[] = {"pushBack", "popBack", "reserve", "read", "write", "size", "compareWrite", "compareWriteOrAbort", "fetchAdd", "fetchMin", "fetchMax", "fetchXor", "pushFront", "popFront"};
+	size_t typeStrIndex = 0;
+	switch (type)
+	{
+	case pushBack:
+		typeStrIndex = 0;
+		break;
+	case popBack:
+		typeStrIndex = 1;
+		break;
+	case reserve:
+		typeStrIndex = 2;
+		break;
+	case read:
+		typeStrIndex = 3;
+		break;
+	case write:
+		typeStrIndex = 4;
+		break;
+	case size:
+		typeStrIndex = 5;
+		break;
+	case compareWrite:
+		typeStrIndex = 6;
+		break;
+	case compareWriteOrAbort:
+		typeStrIndex = 7;
+		break;
+	case fetchAdd:
+		typeStrIndex = 8;
+		break;
+	case fetchMin:
+		typeStrIndex = 9;
+		break;
+	case fetchMax:
+		typeStrIndex = 10;
+		break;
+	case fetchXor:
+		typeStrIndex = 11;
+		break;
+	case pushFront:
+		typeStrIndex = 12;
+		break;
+	case popFront:
+		typeStrIndex = 13;
+		break;
+	}
+	std::cout << "Type:\t" << typeStrList[typeStrIndex] << std::endl;
+	std::cout << "index:\t" << index << std::endl;
+	std::cout << "val:\t" << val << std::endl;
+	if (type == compareWrite || type == compareWriteOrAbort)
+	{
+		std::cout << "expected:\t" << expected << std::endl;
+	}
+	std::cout << "ret:\t" << ret << std::endl;
+}
@@ -0,0 +1,118 @@
+/*
+This file holds the operations a transaction is made of.
+Operations are the same for every engine, so code that picks an engine at runtime can build them without knowing which engine runs them.
+*/
+#ifndef OPERATION_HPP
+#define OPERATION_HPP
+
+#include <cstddef>
+
+#include "define.hpp"
+
+// A standard, user-generated operation.
+// Works with values of type T.
+struct Operation
+{
+	// A high-level operation supported within a transaction.
+	enum OpType
+	{
+		// Write to a position relative to the current size.
+		// Ignores bounds checking, since size reading must be part of the transaction.
+		pushBack,
+		// Read from a position relative to the current size.
+		// Ignores bounds checking, since size reading must be part of the transaction.
+		popBack,
+		// Ensure enough space has been allocated.
+		reserve,
+		// Read at an absolute position in the vector.
+		// Can fail bounds checking.
+		read,
+		// Write at an absolute position in the vector.
+		// Can fail bounds checking.
+		write,
+		// Simillar to read, but always at the size index (probably 1?).
+		// Returned answer can be offset by a transaction's push and pop ops.
+		size,
+		// Write at an absolute position in the vector, but only if it holds the expected value.
+		// The comparison happens as the element is updated, so no other transaction can change it in between.
+		// Returns the value found, so the write happened if it matches the expected value.
+		// Can fail bounds checking.
+		compareWrite,
+		// Like compareWrite, but the whole transaction aborts if the value doesn't match.
+		compareWriteOrAbort,
+		// Combine a value into an absolute position, without reading it.
+		// Updates of the same kind commute, so transactions applying them to one element don't conflict with each other.
+		// Elements that hold no value are left unset. Mixing these with any other operation on the same element aborts.
+		// Add the value, wrapping on overflow.
+		fetchAdd,
+		// Keep the smaller of the two values.
+		fetchMin,
+		// Keep the larger of the two values.
+		fetchMax,
+		// Exclusive or the value in.
+		fetchXor,
+		// Write in front of the first element, which then becomes index 0.
+		// Only deques support this. It aborts once the deque is full.
+		pushFront,
+		// Read and remove the first element, so the one after it becomes index 0.
+		// Only deques support this.
+		popFront,
+	};
+
+	// Check if an operation type works on an absolute index.
+	static bool isIndexed(OpType type)
+	{
+		return type == read || type == write || type == compareWrite || type == compareWriteOrAbort || isDelta(type);
+	}
+	// Check if an operation type is a commutative update.
+	static bool isDelta(OpType type)
+	{
+		return type == fetchAdd || type == fetchMin || type == fetchMax || type == fetchXor;
+	}
+	// Check if a commutative update can turn an element's value into UNSET.
+	// Only sums and xors can, since a min or max always returns one of its inputs.
+	static bool canUnset(OpType type)
+	{
+		return type == fetchAdd || type == fetchXor;
+	}
+	// Combine a commutative update's value into an element's current value.
+	// Also merges two updates of the same type into one.
+	// NOTE: A result that happens to equal UNSET reads as an unset element, so the vectors abort updates that would produce one.
+	static VAL applyDelta(OpType type, VAL current, VAL operand)
+	{
+		switch (type)
+		{
+		case fetchAdd:
+			return current + operand;
+		case fetchMin:
+			return operand < current ? operand : current;
+		case fetchMax:
+			return operand > current ? operand : current;
+		case fetchXor:
+			return current ^ operand;
+		default:
+			return operand;
+		}
+	}
+
+	// The type of operation being performed.
+	OpType type;
+	// The index being affected by the operation.
+	// Only used for read and write. On a deque, indexes count from the current first element.
+	// Also used as the value for size, mostly because it's a convienient and otherwise unused integer.
+	size_t index;
+	// The value being written.
+	// Used for push, write, the compare writes, and as the operand of the commutative updates.
+	// Pop implicitly writes an unset value for bounds checking.
+	VAL val;
+	// The value a compare write expects to replace.
+	VAL expected;
+	// The return value for this operation.
+	// Only used for read, the pops, and size.
+	// Only safe to read if the transaction has committed.
+	VAL ret;
+
+	void print();
+};
+
+#endif
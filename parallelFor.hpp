@@ -0,0 +1,126 @@
+/*
+This file holds a helper that splits a range of work across threads, and the reductions scans fold values with.
+Bulk operations that run outside of transactions use it to work on disjoint parts of a vector at once.
+*/
+#ifndef PARALLELFOR_HPP
+#define PARALLELFOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "define.hpp"
+
+// Run body(begin, end) over contiguous chunks of [0, count), one chunk per thread.
+// Chunks start on multiples of grain, so no two threads share a grain.
+// The calling thread runs the first chunk itself, and returns once every chunk is done.
+template <class Body>
+void parallelFor(size_t count, size_t grain, unsigned int threads, Body body)
+{
+	size_t grains = (count + grain - 1) / grain;
+	if (threads > grains)
+	{
+		threads = grains;
+	}
+	if (threads <= 1)
+	{
+		if (count != 0)
+		{
+			body(0, count);
+		}
+		return;
+	}
+	std::vector<std::thread> workers;
+	for (unsigned int i = 1; i < threads; i++)
+	{
+		size_t begin = std::min(count, grains * i / threads * grain);
+		size_t end = std::min(count, grains * (i + 1) / threads * grain);
+		workers.emplace_back([&body, begin, end] { body(begin, end); });
+	}
+	body(0, std::min(count, grains / threads * grain));
+	for (std::thread &worker : workers)
+	{
+		worker.join();
+	}
+	return;
+}
+
+// The reductions a scan of a vector can run.
+// count is the number of elements with a value. Counting the elements that match a predicate takes Engine::countIf instead.
+enum class Reduction
+{
+	sum,
+	min,
+	max,
+	count
+};
+
+// The starting value of a reduction. min of no values is UINT64_MAX, and max of none is 0.
+inline uint64_t reductionIdentity(Reduction reduction)
+{
+	return reduction == Reduction::min ? UINT64_MAX : 0;
+}
+
+// Fold a run of values into a partial reduction. Elements without a value are left out.
+// Each loop is branch-free over a plain array, so the compiler can vectorize it.
+inline uint64_t reduceValues(Reduction reduction, uint64_t partial, const VAL *values, size_t count)
+{
+	switch (reduction)
+	{
+	case Reduction::sum:
+		for (size_t i = 0; i < count; i++)
+		{
+			partial += values[i] != UNSET ? values[i] : 0;
+		}
+		break;
+	case Reduction::min:
+	{
+		// UNSET is the largest value, so it never wins.
+		VAL low = UNSET;
+		for (size_t i = 0; i < count; i++)
+		{
+			low = std::min(low, values[i]);
+		}
+		if (low != UNSET)
+		{
+			partial = std::min(partial, (uint64_t)low);
+		}
+		break;
+	}
+	case Reduction::max:
+	{
+		VAL high = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			high = std::max(high, values[i] != UNSET ? values[i] : 0);
+		}
+		partial = std::max(partial, (uint64_t)high);
+		break;
+	}
+	case Reduction::count:
+		for (size_t i = 0; i < count; i++)
+		{
+			partial += values[i] != UNSET;
+		}
+		break;
+	}
+	return partial;
+}
+
+// Merge the partial reductions of two threads.
+inline uint64_t combineReductions(Reduction reduction, uint64_t a, uint64_t b)
+{
+	switch (reduction)
+	{
+	case Reduction::min:
+		return std::min(a, b);
+	case Reduction::max:
+		return std::max(a, b);
+	default:
+		return a + b;
+	}
+}
+
+#endif
@@ -0,0 +1,136 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "region.hpp"
+
+TaggedStack<Region::Chunk> Region::pool;
+
+thread_local Region *Region::own = NULL;
+
+thread_local Region *Region::current = NULL;
+
+std::vector<Region *> Region::orphans;
+
+std::mutex Region::orphansLock;
+
+std::atomic<size_t> Region::reservedBytes(0);
+
+std::atomic<size_t> Region::heldBytes(0);
+
+std::atomic<size_t> Region::highWaterBytes(0);
+
+std::atomic<size_t> Region::oversizedChunks(0);
+
+std::atomic<size_t> Region::persistentBytes(0);
+
+Region::Chunk *Region::grow(size_t size)
+{
+    Chunk *chunk = NULL;
+    if (size <= REGION_CHUNK_SIZE)
+    {
+        size = REGION_CHUNK_SIZE;
+        chunk = pool.pop();
+    }
+    if (chunk == NULL)
+    {
+        chunk = (Chunk *)malloc(sizeof(Chunk) + size);
+        assert(chunk != NULL && "Failed to malloc.");
+        chunk->size = size;
+        reservedBytes.fetch_add(size, std::memory_order_relaxed);
+        if (size > REGION_CHUNK_SIZE)
+        {
+            oversizedChunks.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    raiseHighWater(highWaterBytes, heldBytes.fetch_add(chunk->size, std::memory_order_relaxed) + chunk->size);
+    if (persistent)
+    {
+        persistentBytes.fetch_add(chunk->size, std::memory_order_relaxed);
+    }
+    chunk->next.store(chunks, std::memory_order_relaxed);
+    chunks = chunk;
+    return chunk;
+}
+
+void *Region::allocateSlow(size_t bytes, size_t alignment)
+{
+    // Leave room to align the allocation inside the chunk.
+    size_t size = bytes + alignment;
+    Chunk *chunk = grow(size);
+    char *start = (char *)(chunk + 1);
+    // Oversized allocations get a chunk of their own, so the current chunk keeps its free space.
+    if (size > REGION_CHUNK_SIZE)
+    {
+        return (void *)(((uintptr_t)start + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    }
+    cursor = start;
+    end = start + chunk->size;
+    return allocate(bytes, alignment);
+}
+
+void Region::reset()
+{
+    Chunk *chunk = chunks;
+    while (chunk != NULL)
+    {
+        // Read the link first, since pooling the chunk overwrites it.
+        Chunk *next = chunk->next.load(std::memory_order_relaxed);
+        heldBytes.fetch_sub(chunk->size, std::memory_order_relaxed);
+        if (chunk->size == REGION_CHUNK_SIZE)
+        {
+            pool.push(chunk);
+        }
+        else
+        {
+            reservedBytes.fetch_sub(chunk->size, std::memory_order_relaxed);
+            free(chunk);
+        }
+        chunk = next;
+    }
+    chunks = NULL;
+    cursor = NULL;
+    end = NULL;
+    return;
+}
+
+void Region::threadFinish()
+{
+    if (own == NULL)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(orphansLock);
+    orphans.push_back(own);
+    own = NULL;
+    return;
+}
+
+void Region::adopt()
+{
+    {
+        std::lock_guard<std::mutex> guard(orphansLock);
+        if (!orphans.empty())
+        {
+            own = orphans.back();
+            orphans.pop_back();
+            return;
+        }
+    }
+    own = new Region();
+    own->persistent = true;
+    return;
+}
+
+MemoryStats Region::stats()
+{
+    MemoryStats stats;
+    stats.name = "Region";
+    stats.objectSize = 1;
+    stats.reservedBytes = reservedBytes.load(std::memory_order_relaxed);
+    stats.inUseBytes = heldBytes.load(std::memory_order_relaxed);
+    stats.highWaterBytes = highWaterBytes.load(std::memory_order_relaxed);
+    stats.fallbackAllocations = oversizedChunks.load(std::memory_order_relaxed);
+    // Thread regions are never reset, so whatever they hold stays allocated after its transaction is gone.
+    stats.retiredBytes = persistentBytes.load(std::memory_order_relaxed);
+    return stats;
+}
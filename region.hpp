@@ -0,0 +1,137 @@
+/*
+This file holds the arenas behind MemAllocator.
+A region bump-allocates out of fixed-size chunks and frees everything at once by handing its chunks back to a shared pool.
+*/
+#ifndef REGION_HPP
+#define REGION_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "define.hpp"
+#include "memoryStats.hpp"
+#include "taggedStack.hpp"
+
+class Region
+{
+private:
+    struct Chunk
+    {
+        // Links the chunks of a region, and the free chunks in the pool.
+        std::atomic<Chunk *> next;
+        // The usable bytes following this header.
+        // Only chunks of REGION_CHUNK_SIZE are pooled. Larger ones are freed on reset.
+        size_t size;
+    };
+
+    // Free chunks shared between all threads. Pooled chunks are never returned to the system.
+    static TaggedStack<Chunk> pool;
+    // The region each thread uses outside of any scope.
+    thread_local static Region *own;
+    // Own regions of finished threads, waiting for new threads to take them over.
+    static std::vector<Region *> orphans;
+    static std::mutex orphansLock;
+
+    // Statistics. These only change when whole chunks move.
+    // Bytes taken from the system for chunks.
+    static std::atomic<size_t> reservedBytes;
+    // Bytes in chunks held by regions.
+    static std::atomic<size_t> heldBytes;
+    static std::atomic<size_t> highWaterBytes;
+    // Chunks allocated for a single allocation too large for a pooled chunk.
+    static std::atomic<size_t> oversizedChunks;
+    // Bytes in chunks held by thread regions, which are never reset.
+    static std::atomic<size_t> persistentBytes;
+
+    // Set for thread regions, which are never reset.
+    bool persistent = false;
+    // Every chunk this region holds.
+    Chunk *chunks = NULL;
+    // The free space left in the chunk being carved.
+    char *cursor = NULL;
+    char *end = NULL;
+
+    // Get a new chunk with room for at least size bytes and link it into this region.
+    Chunk *grow(size_t size);
+    // Called once the current chunk runs out.
+    void *allocateSlow(size_t bytes, size_t alignment);
+
+public:
+    // The region MemAllocators on this thread allocate from. NULL means the thread's own region.
+    thread_local static Region *current;
+
+    Region() = default;
+    Region(const Region &) = delete;
+    Region &operator=(const Region &) = delete;
+    ~Region()
+    {
+        reset();
+        return;
+    }
+
+    // Allocate bytes, aligned to alignment (a power of two).
+    void *allocate(size_t bytes, size_t alignment)
+    {
+        uintptr_t start = ((uintptr_t)cursor + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        // An empty region has no chunk, so this also catches the first allocation.
+        if (cursor == NULL || start + bytes > (uintptr_t)end)
+        {
+            return allocateSlow(bytes, alignment);
+        }
+        cursor = (char *)(start + bytes);
+        return (void *)start;
+    }
+    // Release everything allocated from this region at once.
+    // Anything still using memory from the region must be destroyed first.
+    void reset();
+
+    // Get the region allocations on this thread currently go to.
+    static Region &active()
+    {
+        return current != NULL ? *current : threadRegion();
+    }
+    // Get the calling thread's own region.
+    // It is never reset, since shared structures built in it can outlive both their transaction and the thread.
+    static Region &threadRegion()
+    {
+        if (own == NULL)
+        {
+            adopt();
+        }
+        return *own;
+    }
+    // Get a snapshot of the memory used by all regions.
+    static MemoryStats stats();
+    // Give up the calling thread's own region before the thread exits.
+    // The region is not reset. The next thread to need one continues allocating from it.
+    static void threadFinish();
+
+private:
+    // Take over the region of a finished thread, or create one.
+    static void adopt();
+};
+
+// Sends the MemAllocator allocations of this thread to a region while in scope.
+// Scopes nest, and the previous region is restored when the scope ends.
+class RegionScope
+{
+private:
+    Region *previous;
+
+public:
+    RegionScope(Region &region) : previous(Region::current)
+    {
+        Region::current = &region;
+    }
+    RegionScope(const RegionScope &) = delete;
+    RegionScope &operator=(const RegionScope &) = delete;
+    ~RegionScope()
+    {
+        Region::current = previous;
+    }
+};
+
+#endif
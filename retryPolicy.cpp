@@ -0,0 +1,47 @@
+#include <random>
+#include <thread>
+
+#include "retryPolicy.hpp"
+
+RetryPolicy::RetryPolicy(unsigned int attempts, std::chrono::nanoseconds backoff, std::chrono::nanoseconds maxBackoff)
+{
+	this->attempts = attempts;
+	this->backoff = backoff;
+	this->maxBackoff = maxBackoff;
+	retried = 0;
+	retryOn(AbortCause::contention);
+	return;
+}
+
+void RetryPolicy::wait(unsigned int attempt) const
+{
+	// Double the wait with each attempt, without shifting past the maximum.
+	std::chrono::nanoseconds limit = backoff;
+	for (unsigned int i = 1; i < attempt && limit < maxBackoff; i++)
+	{
+		limit *= 2;
+	}
+	if (limit > maxBackoff)
+	{
+		limit = maxBackoff;
+	}
+	if (limit.count() <= 0)
+	{
+		std::this_thread::yield();
+		return;
+	}
+	// Wait somewhere between half and all of the limit.
+	static thread_local std::minstd_rand random(std::hash<std::thread::id>()(std::this_thread::get_id()));
+	std::chrono::nanoseconds delay(limit.count() / 2 + random() % (limit.count() / 2 + 1));
+	if (delay.count() >= RETRY_SPIN_NS)
+	{
+		std::this_thread::sleep_for(delay);
+		return;
+	}
+	auto deadline = std::chrono::steady_clock::now() + delay;
+	while (std::chrono::steady_clock::now() < deadline)
+	{
+		std::this_thread::yield();
+	}
+	return;
+}
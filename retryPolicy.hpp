@@ -0,0 +1,72 @@
+/*
+This file holds the policy for running aborted transactions again.
+Aborts are final for a descriptor, so the retry loops that use a policy run the transaction's operations on a fresh attempt.
+The policy only decides whether and when to retry, so it is the same for every engine.
+*/
+#ifndef RETRYPOLICY_HPP
+#define RETRYPOLICY_HPP
+
+#include <chrono>
+
+#include "define.hpp"
+
+// Why a transaction aborted.
+enum class AbortCause : unsigned char
+{
+	// The transaction hasn't aborted.
+	none,
+	// An operation reached past the elements the vector holds.
+	// Reads of unset elements, pops of an empty vector, and failed reserves all end up here.
+	outOfBounds,
+	// A compare write found a value other than the one it expected.
+	compareFailed,
+	// The transaction combined operations that can't share an element, such as an update and a read.
+	// Also used for updates with an UNSET operand, or that would leave an element reading as UNSET.
+	invalid,
+	// Another transaction forced this one to abort, so that neither waits on the other forever.
+	contention,
+};
+
+// Decides whether and when to run an aborted transaction again.
+class RetryPolicy
+{
+private:
+	// A bit for each cause worth retrying.
+	unsigned int retried;
+
+public:
+	// The most times to run a transaction, including the first.
+	unsigned int attempts;
+	// The wait before the first retry. Each retry after it waits twice as long, up to maxBackoff.
+	std::chrono::nanoseconds backoff;
+	std::chrono::nanoseconds maxBackoff;
+
+	// Make a policy that only retries contention.
+	RetryPolicy(unsigned int attempts = 8, std::chrono::nanoseconds backoff = std::chrono::microseconds(1), std::chrono::nanoseconds maxBackoff = std::chrono::milliseconds(1));
+
+	// Choose whether to retry transactions that abort for a cause.
+	RetryPolicy &retryOn(AbortCause cause, bool retry = true)
+	{
+		if (retry)
+		{
+			retried |= 1u << (unsigned int)cause;
+		}
+		else
+		{
+			retried &= ~(1u << (unsigned int)cause);
+		}
+		return *this;
+	}
+	// Check if a transaction that aborted for a cause should run again.
+	// attempt: The number of times it already ran.
+	bool shouldRetry(AbortCause cause, unsigned int attempt) const
+	{
+		return attempt < attempts && (retried & (1u << (unsigned int)cause)) != 0;
+	}
+	// Wait before running a transaction again.
+	// Waits are randomized, so transactions that aborted each other don't collide again right away.
+	// attempt: The number of times the transaction already ran.
+	void wait(unsigned int attempt) const;
+};
+
+#endif
@@ -1,4 +1,7 @@
 #include "rwSet.hpp"
+#include "transactionPlan.hpp"
+
+BEGIN_ENGINE_NAMESPACE
 
 #if defined SEGMENTVEC || defined COMPACTVEC || defined BOOSTEDVEC
 
@@ -11,6 +14,35 @@ RWSet::~RWSet()
     return;
 }
 
+void RWSet::retire()
+{
+#ifdef SEGMENTVEC
+    operations.forEachPage([](size_t, const std::array<RWOperation *, SGMT_SIZE> &ops) {
+        for (size_t i = 0; i < SGMT_SIZE; i++)
+        {
+            if (ops[i] != NULL)
+            {
+                Allocator<RWOperation>::dealloc(ops[i]);
+            }
+        }
+    });
+#else
+    for (auto &entry : operations)
+    {
+        Allocator<RWOperation>::dealloc(entry.second);
+    }
+#endif
+#ifdef COMPACTVEC
+    if (sizeElement != NULL)
+    {
+        Allocator<CompactElement>::dealloc(sizeElement);
+    }
+#endif
+    // Destroying the set clears its maps before its region releases their memory.
+    Allocator<RWSet>::dealloc(this);
+    return;
+}
+
 #ifdef SEGMENTVEC
 std::pair<size_t, size_t> RWSet::access(size_t pos)
 {
@@ -44,142 +76,189 @@ bool RWSet::createSet(Desc *descriptor, TransactionalVector *vector)
         bool RWSet::createSet(Desc *descriptor, BoostedVector *vector)
 #endif
 {
+    // Every set is retired once its transaction finishes, so build its maps in its own region and recycle them with it.
+    RegionScope scope(region);
 #ifdef COMPACTVEC
     // Set the set's descriptor.
     this->descriptor = descriptor;
+#else
+    ring = vector->ring;
 #endif
-    // Go through each operation.
-    for (size_t i = 0; i < descriptor->size; i++)
+    // Prepared transactions already know how their operations relate to each other.
+    // Their slots are relative to size alone, so deques and front operations take the general path.
+    bool planned = descriptor->plan != NULL && !descriptor->plan->usesFront && ring == 0;
+    bool success = planned ? addPlannedOps(descriptor, vector) : addOps(descriptor, vector);
+    if (!success)
     {
+        return false;
+    }
+
+    // If we accessed size, we need to report what we changed it to.
+#ifdef SEGMENTVEC
+    if (sizeDesc != NULL)
+    {
+        sizeDesc->set(0, NEW_VAL, size);
+        sizeDesc->set(1, NEW_VAL, head);
+    }
+#endif
+#ifdef COMPACTVEC
+    // If size changed.
+    if (sizeElement != NULL)
+    {
+        // Replace our size element in shared memory with a finalized size value.
+        CompactElement newSizeElement;
+        newSizeElement.newVal = size;
+        newSizeElement.oldVal = sizeElement->oldVal;
+        newSizeElement.descriptor = descriptor;
+        // Attempt to update the vector's size to contain the new value.
+        // If this CAS fails, then either the final size value was already set by a helper or a new transaction was associated with size and our transaction already completed long ago.
+        vector->size.compare_exchange_strong(*sizeElement, newSizeElement);
+    }
+#endif
+    return true;
+}
+
 #ifdef SEGMENTVEC
-        std::pair<size_t, size_t> indexes;
+bool RWSet::addOps(Desc *descriptor, TransactionalVector *vector)
 #endif
 #ifdef COMPACTVEC
-        unsigned int indexes;
+    bool RWSet::addOps(Desc *descriptor, CompactVector *vector)
 #endif
 #ifdef BOOSTEDVEC
-        size_t indexes;
+        bool RWSet::addOps(Desc *descriptor, BoostedVector *vector)
 #endif
-        RWOperation *op = NULL;
+{
+    // A deque's indexes count from its head, which is kept beside size.
+    if (ring != 0)
+    {
+        getSize(vector, descriptor);
+#ifndef BOOSTEDVEC
+        if (descriptor->status.load() != Desc::TxStatus::active)
+        {
+            return false;
+        }
+#endif
+    }
+    // Go through each operation.
+    for (size_t i = 0; i < descriptor->size; i++)
+    {
+        // Indexes past the end of a deque's ring would wrap around onto its other elements.
+        if (ring != 0 && Operation::isIndexed(descriptor->ops[i].type) && descriptor->ops[i].index >= ring)
+        {
+            descriptor->abort(AbortCause::outOfBounds);
+            return false;
+        }
         switch (descriptor->ops[i].type)
         {
         case Operation::OpType::read:
-            indexes = access(descriptor->ops[i].index);
-            getOp(op, indexes);
-            // If this location has already been written to, read its value.
-            // This is done to handle operations that are totally internal to the transaction.
-            if (op->lastWriteOp != NULL)
+            if (!addRead(descriptor, i))
             {
-                descriptor->ops[i].ret = op->lastWriteOp->val;
-                // If the value was unset (internal pop?), then our transaction fails.
-                if (op->lastWriteOp->val == UNSET)
-                {
-#ifndef BOOSTEDVEC
-                    descriptor->status.store(Desc::TxStatus::aborted);
-                    // DEBUG: Abort reporting.
-                    //fprintf(stderr, "Aborted!\n");
-#endif
-                    return false;
-                }
+                return false;
             }
-            // We haven't written here before. Request a read from the shared structure.
-            else
+            break;
+        case Operation::OpType::write:
+            if (!addWrite(descriptor, i))
             {
-                if (op->checkBounds == RWOperation::Assigned::unset)
-                {
-                    op->checkBounds = RWOperation::Assigned::yes;
-                }
-                // Add ourselves to the read list.
-                op->readList.push_back(&descriptor->ops[i]);
+                return false;
             }
             break;
-        case Operation::OpType::write:
-            indexes = access(descriptor->ops[i].index);
-            getOp(op, indexes);
-            // If this location has already been written to, read its value.
-            // This is done to handle operations that are totally internal to the transaction.
-            if (op->lastWriteOp != NULL)
+        case Operation::OpType::compareWrite:
+        case Operation::OpType::compareWriteOrAbort:
+            if (!addCompareWrite(descriptor, i))
             {
-                // If the value was unset (internal pop?), then our transaction fails.
-                if (op->lastWriteOp->val == UNSET)
-                {
-#ifndef BOOSTEDVEC
-                    descriptor->status.store(Desc::TxStatus::aborted);
-                    // DEBUG: Abort reporting.
-                    //fprintf(stderr, "Aborted!\n");
-#endif
-                    return false;
-                }
+                return false;
             }
-            // We haven't written here before. Request a read from the shared structure.
-            else
+            break;
+        case Operation::OpType::fetchAdd:
+        case Operation::OpType::fetchMin:
+        case Operation::OpType::fetchMax:
+        case Operation::OpType::fetchXor:
+            if (!addDelta(descriptor, i))
             {
-                if (op->checkBounds == RWOperation::Assigned::unset)
-                {
-                    op->checkBounds = RWOperation::Assigned::yes;
-                }
+                return false;
             }
-            op->lastWriteOp = &descriptor->ops[i];
             break;
         case Operation::OpType::pushBack:
             getSize(vector, descriptor);
             // This should never happen, but make sure we don't have an integer overflow.
-            if (size == std::numeric_limits<decltype(size)>::max())
+            // A deque also can't grow past its ring.
+            if (size == std::numeric_limits<decltype(size)>::max() || (ring != 0 && size == ring))
             {
-#ifndef BOOSTEDVEC
-                descriptor->status.store(Desc::TxStatus::aborted);
+                descriptor->abort(AbortCause::outOfBounds);
                 // DEBUG: Abort reporting.
                 //fprintf(stderr, "Aborted!\n");
-#endif
                 return false;
             }
-            indexes = access(size++);
-
-            getOp(op, indexes);
-            if (op->checkBounds == RWOperation::Assigned::unset)
+            if (!addPush(descriptor, i, locate(size++)))
             {
-                op->checkBounds = RWOperation::Assigned::no;
+                return false;
             }
-            op->lastWriteOp = &descriptor->ops[i];
             break;
         case Operation::OpType::popBack:
             getSize(vector, descriptor);
             // Prevent popping past the bottom of the stack.
             if (size < 1)
             {
-#ifndef BOOSTEDVEC
-                descriptor->status.store(Desc::TxStatus::aborted);
-#endif
+                descriptor->abort(AbortCause::outOfBounds);
                 // DEBUG: Abort reporting.
                 //fprintf(stderr, "Aborted!\n");
                 return false;
             }
-            indexes = access(--size);
-
-            getOp(op, indexes);
-            // If this location has already been written to, read its value. This is done to handle operations that are totally internal to the transaction.
-            if (op->lastWriteOp != NULL)
+            if (!addPop(descriptor, i, locate(--size)))
             {
-                descriptor->ops[i].ret = op->lastWriteOp->val;
+                return false;
             }
-            // We haven't written here before. Request a read from the shared structure.
-            else
+            break;
+        case Operation::OpType::pushFront:
+            // Only deques have a front to push onto.
+            if (ring == 0)
             {
-                // Add ourselves to the read list.
-                op->readList.push_back(&descriptor->ops[i]);
+                descriptor->abort(AbortCause::invalid);
+                return false;
             }
-            // We actually write an unset value here when we pop.
-            // Make sure we explicitly mark as UNSET.
-            // Don't leave this in the hands of the person creating the transactions.
-            descriptor->ops[i].val = UNSET;
-            if (op->checkBounds == RWOperation::Assigned::unset)
+            getSize(vector, descriptor);
+            if (size == ring)
+            {
+                descriptor->abort(AbortCause::outOfBounds);
+                return false;
+            }
+            // The slot before the head becomes the new head.
+            head = (head - 1) & (ring - 1);
+            size++;
+            if (!addPush(descriptor, i, head))
             {
-                op->checkBounds = RWOperation::Assigned::no;
+                return false;
+            }
+            break;
+        case Operation::OpType::popFront:
+            if (ring == 0)
+            {
+                descriptor->abort(AbortCause::invalid);
+                return false;
+            }
+            getSize(vector, descriptor);
+            if (size < 1)
+            {
+                descriptor->abort(AbortCause::outOfBounds);
+                return false;
+            }
+            size--;
+            head = (head + 1) & (ring - 1);
+            // The old head is the slot just before the new one.
+            if (!addPop(descriptor, i, (head - 1) & (ring - 1)))
+            {
+                return false;
             }
-            op->lastWriteOp = &descriptor->ops[i];
             break;
         case Operation::OpType::size:
             getSize(vector, descriptor);
+#ifndef BOOSTEDVEC
+            // Size can't be read once the transaction finished, so leave the result reported by the set that finished it.
+            if (descriptor->status.load() != Desc::TxStatus::active)
+            {
+                return false;
+            }
+#endif
 
             // NOTE: Don't store in ret. Store in index, as a special case for size calls.
             descriptor->ops[i].index = size;
@@ -197,36 +276,327 @@ bool RWSet::createSet(Desc *descriptor, TransactionalVector *vector)
             break;
         }
     }
+    return true;
+}
 
-    // If we accessed size, we need to report what we changed it to.
 #ifdef SEGMENTVEC
-    if (sizeDesc != NULL)
-    {
-        sizeDesc->set(0, NEW_VAL, size);
-    }
+bool RWSet::addPlannedOps(Desc *descriptor, TransactionalVector *vector)
 #endif
 #ifdef COMPACTVEC
-    // If size changed.
-    if (sizeElement != NULL)
-    {
-        // Replace our size element in shared memory with a finalized size value.
-        CompactElement newSizeElement;
-        newSizeElement.newVal = size;
-        newSizeElement.oldVal = sizeElement->oldVal;
-        newSizeElement.descriptor = descriptor;
-        // Attempt to update the vector's size to contain the new value.
-        // If this CAS fails, then either the final size value was already set by a helper or a new transaction was associated with size and our transaction already completed long ago.
-        vector->size.compare_exchange_strong(*sizeElement, newSizeElement);
-    }
+    bool RWSet::addPlannedOps(Desc *descriptor, CompactVector *vector)
 #endif
 #ifdef BOOSTEDVEC
-    if (hasSize)
+        bool RWSet::addPlannedOps(Desc *descriptor, BoostedVector *vector)
+#endif
+{
+    const TransactionPlan *plan = descriptor->plan;
+    // The size-relative slots start here.
+    size_t base = 0;
+    if (plan->usesSize)
     {
-        vector->size = size;
-        // DEBUG:
-        //printf("to %lu\n", vector->size);
-    }
+        getSize(vector, descriptor);
+#ifndef BOOSTEDVEC
+        // Size can't be read once the transaction finished, so leave the results reported by the set that finished it.
+        if (descriptor->status.load() != Desc::TxStatus::active)
+        {
+            return false;
+        }
 #endif
+        // Prevent popping past the bottom of the stack, or pushing past the top of size_t.
+        if (size < plan->popDepth || size - plan->popDepth > std::numeric_limits<decltype(size)>::max() - plan->slots.size())
+        {
+            descriptor->abort(AbortCause::outOfBounds);
+            return false;
+        }
+        base = size - plan->popDepth;
+        // The plan assumes nothing else touches the size-relative slots.
+        // If a bound index lands among them, the general path orders the operations one at a time instead.
+        if (plan->usesIndexes)
+        {
+            for (size_t i = 0; i < descriptor->size; i++)
+            {
+                if ((plan->types[i] == Operation::OpType::read || plan->types[i] == Operation::OpType::write ||
+                     plan->types[i] == Operation::OpType::compareWrite || plan->types[i] == Operation::OpType::compareWriteOrAbort ||
+                     Operation::isDelta(plan->types[i])) &&
+                    descriptor->ops[i].index >= base && descriptor->ops[i].index - base < plan->slots.size())
+                {
+                    return addOps(descriptor, vector);
+                }
+            }
+        }
+    }
+
+    // Each slot gets a single element location, already resolved against every push and pop on it.
+    for (size_t i = 0; i < plan->slots.size(); i++)
+    {
+        const TransactionPlan::Slot &slot = plan->slots[i];
+        RWOperation *op = NULL;
+        getOp(op, access(base + i));
+        // The slots lie between the bottom of the pops and the top of the pushes, so they never need bounds checks.
+        op->checkBounds = RWOperation::Assigned::no;
+        op->lastWriteOp = &descriptor->ops[slot.lastWriter];
+        if (slot.sharedReader != SIZE_MAX)
+        {
+            op->readList.push_back(&descriptor->ops[slot.sharedReader]);
+        }
+    }
+
+    for (size_t i = 0; i < descriptor->size; i++)
+    {
+        switch (plan->types[i])
+        {
+        case Operation::OpType::read:
+            if (!addRead(descriptor, i))
+            {
+                return false;
+            }
+            break;
+        case Operation::OpType::write:
+            if (!addWrite(descriptor, i))
+            {
+                return false;
+            }
+            break;
+        case Operation::OpType::compareWrite:
+        case Operation::OpType::compareWriteOrAbort:
+            if (!addCompareWrite(descriptor, i))
+            {
+                return false;
+            }
+            break;
+        case Operation::OpType::fetchAdd:
+        case Operation::OpType::fetchMin:
+        case Operation::OpType::fetchMax:
+        case Operation::OpType::fetchXor:
+            if (!addDelta(descriptor, i))
+            {
+                return false;
+            }
+            break;
+        case Operation::OpType::popBack:
+            // Pops write an unset value, and pops of earlier pushes return the pushed value directly.
+            descriptor->ops[i].val = UNSET;
+            if (plan->sources[i] != SIZE_MAX)
+            {
+                descriptor->ops[i].ret = descriptor->ops[plan->sources[i]].val;
+            }
+            break;
+        case Operation::OpType::size:
+            // NOTE: Don't store in ret. Store in index, as a special case for size calls.
+            descriptor->ops[i].index = base + plan->positions[i];
+            break;
+        case Operation::OpType::reserve:
+            if ((size_t)descriptor->ops[i].index > maxReserveAbsolute)
+            {
+                maxReserveAbsolute = descriptor->ops[i].index;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (plan->usesSize)
+    {
+        size = base + plan->endPosition;
+    }
+    return true;
+}
+
+bool RWSet::addPush(Desc *descriptor, size_t i, size_t pos)
+{
+    RWOperation *op = NULL;
+    getOp(op, access(pos));
+    // Updates only merge with other updates.
+    if (op->hasDelta)
+    {
+        descriptor->abort(AbortCause::invalid);
+        return false;
+    }
+    if (op->checkBounds == RWOperation::Assigned::unset)
+    {
+        op->checkBounds = RWOperation::Assigned::no;
+    }
+    op->lastWriteOp = &descriptor->ops[i];
+    return true;
+}
+
+bool RWSet::addPop(Desc *descriptor, size_t i, size_t pos)
+{
+    RWOperation *op = NULL;
+    getOp(op, access(pos));
+    // If this location has already been written to, read its value. This is done to handle operations that are totally internal to the transaction.
+    // Pending compares and updates have no value to read until the element is updated.
+    if (op->pendingCompare() || op->hasDelta)
+    {
+        descriptor->abort(AbortCause::invalid);
+        return false;
+    }
+    if (op->lastWriteOp != NULL)
+    {
+        descriptor->ops[i].ret = op->lastWriteOp->val;
+    }
+    // We haven't written here before. Request a read from the shared structure.
+    else
+    {
+        // Add ourselves to the read list.
+        op->readList.push_back(&descriptor->ops[i]);
+    }
+    // We actually write an unset value here when we pop.
+    // Make sure we explicitly mark as UNSET.
+    // Don't leave this in the hands of the person creating the transactions.
+    descriptor->ops[i].val = UNSET;
+    if (op->checkBounds == RWOperation::Assigned::unset)
+    {
+        op->checkBounds = RWOperation::Assigned::no;
+    }
+    op->lastWriteOp = &descriptor->ops[i];
+    return true;
+}
+
+bool RWSet::addRead(Desc *descriptor, size_t i)
+{
+    RWOperation *op = NULL;
+    getOp(op, access(locate(descriptor->ops[i].index)));
+    // Whether an earlier compare write goes through, or what an earlier update produces, is only known once the element is updated.
+    if (op->pendingCompare() || op->hasDelta)
+    {
+        descriptor->abort(AbortCause::invalid);
+        return false;
+    }
+    // If this location has already been written to, read its value.
+    // This is done to handle operations that are totally internal to the transaction.
+    if (op->lastWriteOp != NULL)
+    {
+        descriptor->ops[i].ret = op->lastWriteOp->val;
+        // If the value was unset (internal pop?), then our transaction fails.
+        if (op->lastWriteOp->val == UNSET)
+        {
+            descriptor->abort(AbortCause::outOfBounds);
+            // DEBUG: Abort reporting.
+            //fprintf(stderr, "Aborted!\n");
+            return false;
+        }
+    }
+    // We haven't written here before. Request a read from the shared structure.
+    else
+    {
+        if (op->checkBounds == RWOperation::Assigned::unset)
+        {
+            op->checkBounds = RWOperation::Assigned::yes;
+        }
+        // Add ourselves to the read list.
+        op->readList.push_back(&descriptor->ops[i]);
+    }
+    return true;
+}
+
+bool RWSet::addWrite(Desc *descriptor, size_t i)
+{
+    RWOperation *op = NULL;
+    getOp(op, access(locate(descriptor->ops[i].index)));
+    // Updates only merge with other updates.
+    if (op->hasDelta)
+    {
+        descriptor->abort(AbortCause::invalid);
+        return false;
+    }
+    // If this location has already been written to, read its value.
+    // This is done to handle operations that are totally internal to the transaction.
+    if (op->lastWriteOp != NULL)
+    {
+        // If the value was unset (internal pop?), then our transaction fails.
+        if (op->lastWriteOp->val == UNSET)
+        {
+            descriptor->abort(AbortCause::outOfBounds);
+            // DEBUG: Abort reporting.
+            //fprintf(stderr, "Aborted!\n");
+            return false;
+        }
+    }
+    // We haven't written here before. Request a read from the shared structure.
+    else
+    {
+        if (op->checkBounds == RWOperation::Assigned::unset)
+        {
+            op->checkBounds = RWOperation::Assigned::yes;
+        }
+    }
+    op->lastWriteOp = &descriptor->ops[i];
+    return true;
+}
+
+bool RWSet::addCompareWrite(Desc *descriptor, size_t i)
+{
+    RWOperation *op = NULL;
+    Operation *compare = &descriptor->ops[i];
+    getOp(op, access(locate(compare->index)));
+    if (op->pendingCompare() || op->hasDelta)
+    {
+        descriptor->abort(AbortCause::invalid);
+        return false;
+    }
+    // If this location has already been written to, compare against that value right away.
+    if (op->lastWriteOp != NULL)
+    {
+        compare->ret = op->lastWriteOp->val;
+        // Abort on an unset value (internal pop?), or on a mismatch if asked to.
+        if (compare->ret == UNSET || (compare->ret != compare->expected && compare->type == Operation::OpType::compareWriteOrAbort))
+        {
+            descriptor->abort(compare->ret == UNSET ? AbortCause::outOfBounds : AbortCause::compareFailed);
+            return false;
+        }
+        if (compare->ret == compare->expected)
+        {
+            op->lastWriteOp = compare;
+        }
+        return true;
+    }
+    // Otherwise, compare against shared memory once the element is updated.
+    // Only the first compare gets there, since any compare after it sees its value in lastWriteOp.
+    if (op->checkBounds == RWOperation::Assigned::unset)
+    {
+        op->checkBounds = RWOperation::Assigned::yes;
+    }
+    // Read the old value along with the comparison.
+    op->readList.push_back(compare);
+    op->compareOp = compare;
+    op->lastWriteOp = compare;
+    return true;
+}
+
+bool RWSet::addDelta(Desc *descriptor, size_t i)
+{
+    RWOperation *op = NULL;
+    Operation *update = &descriptor->ops[i];
+    getOp(op, access(locate(update->index)));
+    // Pages and elements store the operand as a new value, where UNSET would read as an unset element.
+    if (update->val == UNSET)
+    {
+        descriptor->abort(AbortCause::invalid);
+        return false;
+    }
+    // Merge with an earlier update of the same type.
+    if (op->hasDelta && op->deltaType == update->type)
+    {
+        op->delta = Operation::applyDelta(update->type, op->delta, update->val);
+        if (op->delta == UNSET)
+        {
+            descriptor->abort(AbortCause::invalid);
+            return false;
+        }
+        return true;
+    }
+    // An update only commutes with updates of its own type, so it can't share an element with anything else.
+    if (op->hasDelta || op->lastWriteOp != NULL || !op->readList.empty())
+    {
+        descriptor->abort(AbortCause::invalid);
+        return false;
+    }
+    // Updates never check bounds, since they leave unset elements alone.
+    op->hasDelta = true;
+    op->deltaType = update->type;
+    op->delta = update->val;
     return true;
 }
 
@@ -234,12 +604,13 @@ bool RWSet::createSet(Desc *descriptor, TransactionalVector *vector)
 void RWSet::setToPages(Desc *descriptor)
 {
     // All of the pages we want to insert (except size), ordered from low to high.
-    std::map<size_t, Page<VAL, SGMT_SIZE> *, ORDER, MyPageAllocator> *pages = Allocator<std::map<size_t, Page<VAL, SGMT_SIZE> *, ORDER, MyPageAllocator>>::alloc();
+    // The map belongs to the descriptor and is read by helpers, so it goes in its own region rather than this set's.
+    PageMap *pages = Allocator<PageMap>::alloc();
+    RegionScope scope(pages->region);
 
     // For each page to generate.
     // These are all independent of shared memory.
-    for (auto i = operations.begin(); i != operations.end(); ++i)
-    {
+    operations.forEachPage([&](size_t pageIndex, const std::array<RWOperation *, SGMT_SIZE> &ops) {
         // Create the initial page.
         Page<VAL, SGMT_SIZE> *page = Allocator<Page<VAL, SGMT_SIZE>>::alloc();
         // Link the page to the transaction descriptor.
@@ -247,12 +618,12 @@ void RWSet::setToPages(Desc *descriptor)
 
         for (size_t j = 0; j < SGMT_SIZE; j++)
         {
-            RWOperation *op = i->second[j];
+            RWOperation *op = ops[j];
             // Ignore NULL elements in the array.
             if (op == NULL)
             {
                 // DEBUG: NULL element in the array.
-                //printf("No op at page %lu index %lu\n", i->first, j);
+                //printf("No op at page %lu index %lu\n", pageIndex, j);
                 continue;
             }
             // Infer a read based on the read list size.
@@ -261,19 +632,37 @@ void RWSet::setToPages(Desc *descriptor)
             page->bitset.write[j] = (op->lastWriteOp != NULL);
             // Check bounds only if the first operation on this element needed to.
             page->bitset.checkBounds[j] = (op->checkBounds == RWOperation::Assigned::yes) ? true : false;
+            // Compare against the old value once it is found.
+            page->bitset.compare[j] = (op->compareOp != NULL);
+            // Updates only carry their merged operand, which is combined with the element's value whenever it is read.
+            page->bitset.delta[j] = op->hasDelta;
+            // Sums and xors find the old value after all, to abort rather than leave the element reading as unset.
+            page->bitset.checkDelta[j] = op->hasDelta && Operation::canUnset(op->deltaType);
+            if (op->hasDelta)
+            {
+                page->setDelta(j, op->deltaType, op->delta);
+            }
             // If a write occured, place the appropriate new value from it.
             if (op->lastWriteOp != NULL)
             {
                 page->set(j, NEW_VAL, op->lastWriteOp->val);
             }
         }
-        (*pages)[i->first] = page;
-    }
+        pages->map[pageIndex] = page;
+    });
 
     // Store a pointer to the pages in the descriptor.
     // Only the first thread to finish the job succeeds here.
-    std::map<size_t, Page<VAL, SGMT_SIZE> *, ORDER, MyPageAllocator> *nullVal = NULL;
-    descriptor->pages.compare_exchange_strong(nullVal, pages);
+    PageMap *nullVal = NULL;
+    if (!descriptor->pages.compare_exchange_strong(nullVal, pages))
+    {
+        // Another thread published its pages first. Ours were never shared, so recycle them.
+        for (auto &entry : pages->map)
+        {
+            Allocator<Page<VAL, SGMT_SIZE>>::dealloc(entry.second);
+        }
+        Allocator<PageMap>::dealloc(pages);
+    }
 
     return;
 }
@@ -288,16 +677,18 @@ size_t RWSet::getSize(TransactionalVector *vector, Desc *descriptor)
     }
 
     // Prepend a read page to size.
-    // The size page is always of size 1.
+    // The size page holds size and a deque's head, which always change together.
     // Set all unchanging page values here.
-    Page<size_t, 1> *tempSizeDesc = Allocator<Page<size_t, 1>>::alloc();
+    Page<size_t, 2> *tempSizeDesc = Allocator<Page<size_t, 2>>::alloc();
     tempSizeDesc->bitset.read.set();
     tempSizeDesc->bitset.write.set();
     tempSizeDesc->bitset.checkBounds.reset();
     tempSizeDesc->transaction = descriptor;
     tempSizeDesc->next = NULL;
 
-    Page<size_t, 1> *rootPage = NULL;
+    // The size page in the vector. Every set of the transaction fills in the same one, so the published set always does.
+    Page<size_t, 2> *installed = tempSizeDesc;
+    Page<size_t, 2> *rootPage = NULL;
     do
     {
         // Get the current head.
@@ -315,11 +706,13 @@ size_t RWSet::getSize(TransactionalVector *vector, Desc *descriptor)
         {
             // Assume an initial size of 0.
             tempSizeDesc->set(0, OLD_VAL, 0);
+            tempSizeDesc->set(1, OLD_VAL, 0);
         }
         // If a helper got here first.
         else if (rootPage->transaction == tempSizeDesc->transaction)
         {
-            // Do not insert again.
+            // Do not insert again. Share the helper's page instead.
+            installed = rootPage;
             break;
         }
         else
@@ -334,30 +727,45 @@ size_t RWSet::getSize(TransactionalVector *vector, Desc *descriptor)
                 status = rootPage->transaction->status.load();
             }
 
-            // Store the root page's value as an old value in case we abort.
-            // Get the appropriate value from the root page depending on whether or not it succeeded.
-            size_t value = UNSET;
-            if (status == Desc::TxStatus::committed)
+            // Store the root page's values as old values in case we abort.
+            // Get the appropriate values from the root page depending on whether or not it succeeded.
+            for (size_t j = 0; j < Page<size_t, 2>::SEG_SIZE; j++)
             {
-                rootPage->get(0, NEW_VAL, value);
-            }
-            else
-            {
-                rootPage->get(0, OLD_VAL, value);
+                size_t value = UNSET;
+                if (status == Desc::TxStatus::committed)
+                {
+                    rootPage->get(j, NEW_VAL, value);
+                }
+                else
+                {
+                    rootPage->get(j, OLD_VAL, value);
+                }
+                tempSizeDesc->set(j, OLD_VAL, value);
             }
-            tempSizeDesc->set(0, OLD_VAL, value);
         }
         // Append the old page onto the new page. Used to maintain history.
         tempSizeDesc->next = rootPage;
     }
     // Replace the page. Finish on success. Retry on failure.
     while (!vector->size.compare_exchange_weak(rootPage, tempSizeDesc));
+    if (installed != tempSizeDesc)
+    {
+        // Our page never went in, so nobody else has seen it.
+        Allocator<Page<size_t, 2>>::dealloc(tempSizeDesc);
+    }
+    else if (rootPage != NULL)
+    {
+        // The old size page stays in the chain as history.
+        Allocator<Page<size_t, 2>>::retire();
+    }
 
     // Store the actual size locally.
-    vector->size.load()->get(0, OLD_VAL, size);
+    // Read it from our own page, since later transactions may already have replaced it in the vector.
+    installed->get(0, OLD_VAL, size);
+    installed->get(1, OLD_VAL, head);
 
     // Store the descriptor locally.
-    sizeDesc = tempSizeDesc;
+    sizeDesc = installed;
 
     return size;
 }
@@ -459,26 +867,161 @@ size_t RWSet::getSize(BoostedVector *vector, Desc *descriptor)
     {
         return size;
     }
-    vector->sizeLock.lock.lock();
-    descriptor->locks.push_back(&vector->sizeLock);
-    size = vector->size;
+    size_t delta = 0;
+    // Positions in a deque depend on its head as well, so nothing else may move either one meanwhile.
+    sizeMode = ring != 0 ? SizeLock::Mode::exclusive : sizeLockMode(descriptor, delta);
+    vector->sizeLock.lock(sizeMode);
+    switch (sizeMode)
+    {
+    case SizeLock::Mode::push:
+    {
+        // Claim our slots up front, but only once they are sure to fit. Concurrent pushers take the slots after ours.
+        // Nothing can fail once they are claimed, so an abort never leaves holes below the slots of other pushers.
+        bool claimed = false;
+        size = vector->size.load();
+        while (!claimed && vector->reserve(size + delta))
+        {
+            claimed = vector->size.compare_exchange_weak(size, size + delta);
+        }
+        if (!claimed)
+        {
+            // Fall back on holding size exclusively, which fails the same way without changing it.
+            vector->sizeLock.unlock(sizeMode);
+            sizeMode = SizeLock::Mode::exclusive;
+            vector->sizeLock.lock(sizeMode);
+            size = vector->size.load();
+            head = vector->head.load();
+        }
+        break;
+    }
+    case SizeLock::Mode::pop:
+        // Claim the top slots. Concurrent poppers take the slots below ours.
+        size = vector->size.load();
+        while (size >= delta && !vector->size.compare_exchange_weak(size, size - delta))
+        {
+            continue;
+        }
+        // If there are too few elements, createSet hits the bottom and aborts without size ever changing.
+        break;
+    default:
+        size = vector->size.load();
+        head = vector->head.load();
+        break;
+    }
     // DEBUG:
-    //printf("Size changed from %lu ", vector->size);
+    //printf("Size changed from %lu ", vector->size.load());
     hasSize = true;
     return size;
 }
+
+SizeLock::Mode RWSet::sizeLockMode(Desc *descriptor, size_t &delta)
+{
+    size_t pushes = 0;
+    size_t pops = 0;
+    // Set if the transaction does anything that must see a stable size or could abort after reserving slots.
+    // Any group of a transaction spanning several vectors could abort because of another group.
+    bool needsExclusive = descriptor->groups != NULL;
+    // Prepared transactions counted these when they were compiled.
+    if (descriptor->plan != NULL)
+    {
+        pushes = descriptor->plan->pushes;
+        pops = descriptor->plan->pops;
+        needsExclusive = needsExclusive || descriptor->plan->exclusiveSize;
+    }
+    for (size_t i = 0; descriptor->plan == NULL && i < descriptor->size; i++)
+    {
+        switch (descriptor->ops[i].type)
+        {
+        case Operation::OpType::pushBack:
+            pushes++;
+            break;
+        case Operation::OpType::popBack:
+            pops++;
+            break;
+        case Operation::OpType::reserve:
+            break;
+        default:
+            needsExclusive = true;
+            break;
+        }
+    }
+    if (!needsExclusive && pops == 0)
+    {
+        delta = pushes;
+        return SizeLock::Mode::push;
+    }
+    if (!needsExclusive && pushes == 0)
+    {
+        delta = pops;
+        return SizeLock::Mode::pop;
+    }
+    return SizeLock::Mode::exclusive;
+}
 #endif
 
 #ifdef SEGMENTVEC
 void RWSet::getOp(RWOperation *&op, std::pair<size_t, size_t> indexes)
 {
-    op = operations[indexes.first][indexes.second];
-    if (op == NULL)
+    RWOperation *&entry = operations.at(indexes.first, indexes.second);
+    if (entry == NULL)
     {
-        op = Allocator<RWOperation>::alloc();
-        assert(op != NULL);
-        operations[indexes.first][indexes.second] = op;
+        entry = Allocator<RWOperation>::alloc();
+        assert(entry != NULL);
+    }
+    op = entry;
+    return;
+}
+
+RWOperation *&RWOpMap::at(size_t page, size_t offset)
+{
+    if (!spilled)
+    {
+        size_t key = page * SGMT_SIZE + offset;
+        // Find the first entry not below our key.
+        // Linear search beats binary search at these sizes.
+        size_t i = 0;
+        while (i < flatCount && flat[i].key < key)
+        {
+            i++;
+        }
+        if (i < flatCount && flat[i].key == key)
+        {
+            return flat[i].op;
+        }
+        if (flatCount < FLAT_RWSET_SIZE)
+        {
+            // Shift larger keys up to keep the array sorted.
+            for (size_t j = flatCount; j > i; j--)
+            {
+                flat[j] = flat[j - 1];
+            }
+            flat[i].key = key;
+            flat[i].op = NULL;
+            flatCount++;
+            return flat[i].op;
+        }
+        // Out of inline space.
+        spill();
+    }
+    return map[page][offset];
+}
+
+void RWOpMap::spill()
+{
+    for (size_t i = 0; i < flatCount; i++)
+    {
+        map[flat[i].key / SGMT_SIZE][flat[i].key % SGMT_SIZE] = flat[i].op;
     }
+    flatCount = 0;
+    spilled = true;
+    return;
+}
+
+void RWOpMap::clear()
+{
+    map.clear();
+    flatCount = 0;
+    spilled = false;
     return;
 }
 #endif
@@ -499,16 +1042,17 @@ bool RWSet::getOp(RWOperation *&op, size_t index)
 #ifdef SEGMENTVEC
 void RWSet::printOps()
 {
-    for (auto it = operations.begin(); it != operations.end(); ++it)
-    {
-        std::cout << "Page " << it->first << std::endl;
+    operations.forEachPage([](size_t pageIndex, const std::array<RWOperation *, SGMT_SIZE> &ops) {
+        std::cout << "Page " << pageIndex << std::endl;
         for (int i = SGMT_SIZE - 1; i >= 0; i--)
         {
-            std::cout << (it->second[i] == NULL ? SGMT_SIZE + 1 : i) << " ";
+            std::cout << (ops[i] == NULL ? SGMT_SIZE + 1 : i) << " ";
         }
         std::cout << std::endl;
-    }
+    });
     return;
 }
 #endif
-#endif
\ No newline at end of file
+#endif
+
+END_ENGINE_NAMESPACE
\ No newline at end of file
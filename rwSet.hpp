@@ -1,6 +1,7 @@
 #ifndef RWSET_HPP
 #define RWSET_HPP
 
+#include <array>
 #include <atomic>
 #include <cstddef>
 #include <ostream>
@@ -11,18 +12,29 @@
 #include "define.hpp"
 #include "deltaPage.hpp"
 #include "memAllocator.hpp"
+#include "sizeLock.hpp"
+#include "operation.hpp"
 #include "transaction.hpp"
 #ifdef SEGMENTVEC
 #include "transVector.hpp"
-class TransactionalVector;
 #endif
 #ifdef COMPACTVEC
 #include "compactVector.hpp"
+#endif
+#ifdef BOOSTEDVEC
+#include "boostedVector.hpp"
+#endif
+
+BEGIN_ENGINE_NAMESPACE
+
+#ifdef SEGMENTVEC
+class TransactionalVector;
+#endif
+#ifdef COMPACTVEC
 class CompactVector;
 class CompactElement;
 #endif
 #ifdef BOOSTEDVEC
-#include "boostedVector.hpp"
 class BoostedVector;
 class BoostedElement;
 #endif
@@ -30,7 +42,6 @@ class BoostedElement;
 #if defined SEGMENTVEC || defined COMPACTVEC || defined BOOSTEDVEC
 
 class RWOperation;
-class Operation;
 class Desc;
 
 #ifdef SEGMENTVEC
@@ -39,6 +50,59 @@ typedef MemAllocator<std::pair<size_t, RWOperation *>> MySecondRWOpAllocator;
 typedef MemAllocator<std::pair<size_t, std::map<size_t, RWOperation *, ORDER, MySecondRWOpAllocator>>> MyRWOpAllocator;
 #endif
 
+// A list of operations reading the same location.
+// Most locations have a single reader, so the first few readers are stored inline and only longer lists allocate.
+class ReadList
+{
+private:
+	Operation *inlineOps[READ_LIST_SIZE];
+	// The total number of readers, inline or not.
+	size_t count = 0;
+	// Readers past the inline ones. Only allocated once the inline space runs out.
+	std::vector<Operation *> *overflow = NULL;
+
+public:
+	ReadList() = default;
+	ReadList(const ReadList &) = delete;
+	ReadList &operator=(const ReadList &) = delete;
+	~ReadList()
+	{
+		delete overflow;
+		return;
+	}
+	void push_back(Operation *op)
+	{
+		if (count < READ_LIST_SIZE)
+		{
+			inlineOps[count++] = op;
+			return;
+		}
+		if (overflow == NULL)
+		{
+			overflow = new std::vector<Operation *>();
+		}
+		overflow->push_back(op);
+		count++;
+		return;
+	}
+	Operation *operator[](size_t index) const
+	{
+		if (index < READ_LIST_SIZE)
+		{
+			return inlineOps[index];
+		}
+		return (*overflow)[index - READ_LIST_SIZE];
+	}
+	size_t size() const
+	{
+		return count;
+	}
+	bool empty() const
+	{
+		return count == 0;
+	}
+};
+
 // An individual operation on a single element location.
 struct RWOperation
 {
@@ -59,13 +123,102 @@ struct RWOperation
 	Operation *lastWriteOp = NULL;
 	// Keep a list of operations that want to read the old value.
 	// If this isn't empty, we can infer a read for our page's bitset.
-	std::vector<Operation *, MemAllocator<Operation *>> readList;
+	ReadList readList;
+	// A compare write checked against the value in shared memory, when the element is updated.
+	// Only set if nothing earlier in the transaction wrote here. Later compare writes check the transaction's own value instead.
+	Operation *compareOp = NULL;
+	// Commutative updates are merged into a single one, applied to whatever the element holds once it is updated.
+	// Only set if every operation on this element is an update of the same type.
+	bool hasDelta = false;
+	Operation::OpType deltaType;
+	VAL delta;
+
+	// Check if this element gets a new value, from a write or an update.
+	bool writes() const
+	{
+		return lastWriteOp != NULL || hasDelta;
+	}
+	// Check if the latest write is a compare write that may be skipped.
+	// Its outcome is only known once the element is updated, so nothing later in the transaction can read it.
+	bool pendingCompare() const
+	{
+		return compareOp != NULL && compareOp == lastWriteOp && compareOp->type == Operation::OpType::compareWrite;
+	}
+};
+
+#ifdef SEGMENTVEC
+// Maps element locations to read/write operations.
+// Short transactions keep their entries in a sorted inline array, so building a set never touches the hashed map.
+// Once a transaction outgrows the array, every entry spills into the map.
+class RWOpMap
+{
+public:
+	typedef std::unordered_map<size_t,
+							   std::array<RWOperation *, SGMT_SIZE>,
+							   std::hash<size_t>,
+							   std::equal_to<size_t>,
+							   MemAllocator<std::pair<size_t, std::array<RWOperation *, SGMT_SIZE>>>>
+		PageMap;
+
+	// Get the operation slot for a page and offset, creating an empty one if needed.
+	RWOperation *&at(size_t page, size_t offset);
+	// Call function(page, ops) once for each page, where ops holds the page's SGMT_SIZE operation pointers.
+	template <typename Function>
+	void forEachPage(Function function);
+	// Remove all entries.
+	void clear();
+
+private:
+	// An inline entry. The key is the absolute element position, so sorting by key also groups entries by page.
+	struct Entry
+	{
+		size_t key;
+		RWOperation *op;
+	};
+	Entry flat[FLAT_RWSET_SIZE];
+	// The number of inline entries in use.
+	size_t flatCount = 0;
+	// Set once the entries have moved into the map.
+	bool spilled = false;
+	PageMap map;
+
+	// Move all inline entries into the map.
+	void spill();
 };
 
+template <typename Function>
+void RWOpMap::forEachPage(Function function)
+{
+	if (spilled)
+	{
+		for (auto i = map.begin(); i != map.end(); ++i)
+		{
+			function(i->first, i->second);
+		}
+		return;
+	}
+	// Group the sorted inline entries by page.
+	size_t i = 0;
+	while (i < flatCount)
+	{
+		size_t page = flat[i].key / SGMT_SIZE;
+		std::array<RWOperation *, SGMT_SIZE> ops = {};
+		for (; i < flatCount && flat[i].key / SGMT_SIZE == page; i++)
+		{
+			ops[flat[i].key % SGMT_SIZE] = flat[i].op;
+		}
+		function(page, ops);
+	}
+	return;
+}
+#endif
+
 // All transactions are converted into a read/write set before modifying the vector.
 class RWSet
 {
 public:
+	// Holds the map nodes of this set. Declared first, so it outlives the maps when the set is destroyed.
+	Region region;
 #ifdef COMPACTVEC
 	// Map vector locations to read/write operations.
 	std::map<size_t,
@@ -85,20 +238,19 @@ public:
 	static size_t access(unsigned int pos);
 	// Converts a transaction descriptor into a read/write set.
 	bool createSet(Desc *descriptor, CompactVector *vector);
+	// Add every operation to the set, one at a time.
+	bool addOps(Desc *descriptor, CompactVector *vector);
+	// Add the operations of a prepared transaction using its plan.
+	bool addPlannedOps(Desc *descriptor, CompactVector *vector);
 	unsigned int getSize(CompactVector *vector, Desc *descriptor = NULL);
 	// Get an op node from a map. Allocate it if it doesn't already exist.
 	bool getOp(RWOperation *&op, size_t index);
 #endif
 #ifdef SEGMENTVEC
 	// Map vector locations to read/write operations.
-	std::unordered_map<size_t,
-					   std::array<RWOperation *, SGMT_SIZE>,
-					   std::hash<size_t>,
-					   std::equal_to<size_t>,
-					   MemAllocator<std::pair<size_t, std::array<RWOperation *, SGMT_SIZE>>>>
-		operations;
+	RWOpMap operations;
 	// Our size descriptor. After reading size, we use this to write a new size value later.
-	Page<size_t, 1> *sizeDesc;
+	Page<size_t, 2> *sizeDesc;
 	// Set this if size changes.
 	size_t size = 0;
 
@@ -106,6 +258,10 @@ public:
 	static std::pair<size_t, size_t> access(size_t pos);
 	// Converts a transaction descriptor into a read/write set.
 	bool createSet(Desc *descriptor, TransactionalVector *vector);
+	// Add every operation to the set, one at a time.
+	bool addOps(Desc *descriptor, TransactionalVector *vector);
+	// Add the operations of a prepared transaction using its plan.
+	bool addPlannedOps(Desc *descriptor, TransactionalVector *vector);
 	// Convert from a set of reads and writes to a list of pages.
 	// A pointer to the pages is stored in the descriptor.
 	void setToPages(Desc *descriptor);
@@ -124,21 +280,59 @@ public:
 		operations;
 	bool hasSize = false;
 	size_t size;
+	// The mode this set holds the vector's size lock in.
+	SizeLock::Mode sizeMode = SizeLock::Mode::none;
 
 	// Return the index associated with a RW operation access.
 	static size_t access(size_t pos);
 	// Converts a transaction descriptor into a read/write set.
 	bool createSet(Desc *descriptor, BoostedVector *vector);
+	// Add every operation to the set, one at a time.
+	bool addOps(Desc *descriptor, BoostedVector *vector);
+	// Add the operations of a prepared transaction using its plan.
+	bool addPlannedOps(Desc *descriptor, BoostedVector *vector);
 	size_t getSize(BoostedVector *vector, Desc *descriptor = NULL);
+	// Pick the weakest size lock mode that still covers every size access in the transaction.
+	// Pure push and pure pop transactions also report how many slots they move size by.
+	static SizeLock::Mode sizeLockMode(Desc *descriptor, size_t &delta);
 	// Get an op node from a map. Allocate it if it doesn't already exist.
 	bool getOp(RWOperation *&op, size_t index);
 #endif
 	// An absolute reserve position.
 	size_t maxReserveAbsolute = 0;
+	// The ring capacity of a deque, or 0 for a plain vector.
+	size_t ring = 0;
+	// The ring position of a deque's first element, as of the operations added so far.
+	size_t head = 0;
+
+	// Get the element location of a position counted from the first element.
+	size_t locate(size_t pos) const
+	{
+		return ring == 0 ? pos : (head + pos) & (ring - 1);
+	}
+
+	// Add a read or write at an absolute index.
+	// i:       The index of the operation in the descriptor.
+	bool addRead(Desc *descriptor, size_t i);
+	bool addWrite(Desc *descriptor, size_t i);
+	bool addCompareWrite(Desc *descriptor, size_t i);
+	// Add a commutative update at an absolute index.
+	bool addDelta(Desc *descriptor, size_t i);
+	// Add a push or pop at an element location.
+	bool addPush(Desc *descriptor, size_t i, size_t pos);
+	bool addPop(Desc *descriptor, size_t i, size_t pos);
+
+	// Recycle this set, its operations, and everything allocated in its region.
+	// Only call this once no other thread can reach the set.
+	// That holds for a set that lost the race to be published, or once its transaction finished and no helpers remain.
+	void retire();
 
 	// Set deconstructor.
 	~RWSet();
 };
 
 #endif
+
+END_ENGINE_NAMESPACE
+
 #endif
\ No newline at end of file
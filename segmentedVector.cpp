@@ -1,5 +1,7 @@
 #include "segmentedVector.hpp"
 
+BEGIN_ENGINE_NAMESPACE
+
 template <typename T>
 size_t SegmentedVector<T>::highestBit(unsigned int val)
 {
@@ -272,4 +274,6 @@ template class SegmentedVector<CompactElement>;
 #endif
 #ifdef BOOSTEDVEC
 template class SegmentedVector<BoostedElement>;
-#endif
\ No newline at end of file
+#endif
+
+END_ENGINE_NAMESPACE
\ No newline at end of file
@@ -15,6 +15,8 @@ We build off of this implementation to add support for those things.
 // Included so our template knows what a page is.
 #include "deltaPage.hpp"
 
+BEGIN_ENGINE_NAMESPACE
+
 template <class T>
 class SegmentedVector
 {
@@ -77,4 +79,6 @@ public:
 	void printBuckets();
 };
 
+END_ENGINE_NAMESPACE
+
 #endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "sizeLock.hpp"
+
+#include <thread>
+
+// Bit layout of the size lock's state word.
+#define SIZE_LOCK_MODE_SHIFT (8 * sizeof(size_t) - 2)
+#define SIZE_LOCK_WAITING ((size_t)1 << (SIZE_LOCK_MODE_SHIFT - 1))
+#define SIZE_LOCK_COUNT (SIZE_LOCK_WAITING - 1)
+
+SizeLock::SizeLock() noexcept
+{
+    state.store(0);
+    return;
+}
+
+void SizeLock::lock(Mode mode)
+{
+    if (mode == none)
+    {
+        return;
+    }
+    size_t modeBits = (size_t)mode << SIZE_LOCK_MODE_SHIFT;
+    while (true)
+    {
+        size_t oldState = state.load();
+        size_t holders = oldState & SIZE_LOCK_COUNT;
+        if (mode == exclusive)
+        {
+            // Only take the lock once every holder has left.
+            // Clear the waiting bit on the way in. Other exclusive waiters will set it again.
+            if (holders == 0)
+            {
+                if (state.compare_exchange_weak(oldState, modeBits | 1))
+                {
+                    return;
+                }
+                continue;
+            }
+            // Announce ourselves, so no new shared holders get in ahead of us.
+            state.fetch_or(SIZE_LOCK_WAITING);
+        }
+        // Shared modes back off while an exclusive locker is waiting.
+        else if ((oldState & SIZE_LOCK_WAITING) == 0)
+        {
+            // Take a free lock in our mode.
+            if (holders == 0)
+            {
+                if (state.compare_exchange_weak(oldState, modeBits | 1))
+                {
+                    return;
+                }
+                continue;
+            }
+            // Join holders of the same mode, since our operations commute with theirs.
+            if ((oldState & ~(SIZE_LOCK_WAITING | SIZE_LOCK_COUNT)) == modeBits)
+            {
+                if (state.compare_exchange_weak(oldState, oldState + 1))
+                {
+                    return;
+                }
+                continue;
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+void SizeLock::unlock(Mode mode)
+{
+    if (mode == none)
+    {
+        return;
+    }
+    size_t oldState = state.load();
+    size_t newState;
+    do
+    {
+        // The last holder out clears the mode, but leaves any waiting exclusive locker announced.
+        if ((oldState & SIZE_LOCK_COUNT) == 1)
+        {
+            newState = oldState & SIZE_LOCK_WAITING;
+        }
+        else
+        {
+            newState = oldState - 1;
+        }
+    } while (!state.compare_exchange_weak(oldState, newState));
+    return;
+}
\ No newline at end of file
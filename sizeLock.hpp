@@ -0,0 +1,32 @@
+#ifndef SIZE_LOCK_HPP
+#define SIZE_LOCK_HPP
+
+#include <atomic>
+#include <cstddef>
+
+// An abstract lock guarding a vector's size.
+// Push-only and pop-only transactions commute with their own kind, so they share the lock with each other.
+// Any other use of size (size reads, mixed pushes and pops) needs it exclusively.
+struct SizeLock
+{
+    // The semantic mode a transaction holds the lock in.
+    enum Mode
+    {
+        none,
+        push,
+        pop,
+        exclusive
+    };
+    // The top two bits hold the current mode.
+    // The next bit is set while an exclusive locker waits, so shared lockers back off and cannot starve it.
+    // The remaining bits count the holders.
+    std::atomic<size_t> state;
+
+    SizeLock() noexcept;
+    // Acquire the lock in the given mode.
+    void lock(Mode mode);
+    // Release a lock acquired in the given mode.
+    void unlock(Mode mode);
+};
+
+#endif
\ No newline at end of file
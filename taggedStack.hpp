@@ -0,0 +1,54 @@
+#ifndef TAGGEDSTACK_HPP
+#define TAGGEDSTACK_HPP
+
+#include <atomic>
+#include <cstdint>
+
+// A lock-free stack of nodes that are never freed.
+// The head packs an ABA tag into the unused top bits of the pointer, so pops stay lock-free without a double-width CAS.
+// Since nodes are never freed, a stale pop can always safely read a node's next pointer.
+// Node must have a std::atomic<Node *> next member.
+template <typename Node>
+class TaggedStack
+{
+private:
+    static const uintptr_t POINTER_BITS = ((uintptr_t)1 << 48) - 1;
+
+    std::atomic<uintptr_t> head;
+
+    static uintptr_t nextTag(uintptr_t head)
+    {
+        // Overflowing the tag just wraps it around.
+        return (head & ~POINTER_BITS) + POINTER_BITS + 1;
+    }
+
+public:
+    constexpr TaggedStack() : head(0) {}
+
+    void push(Node *node)
+    {
+        uintptr_t oldHead = head.load();
+        do
+        {
+            node->next.store((Node *)(oldHead & POINTER_BITS));
+        } while (!head.compare_exchange_weak(oldHead, (uintptr_t)node | nextTag(oldHead)));
+        return;
+    }
+    // Returns NULL if the stack is empty.
+    Node *pop()
+    {
+        uintptr_t oldHead = head.load();
+        Node *node = NULL;
+        do
+        {
+            node = (Node *)(oldHead & POINTER_BITS);
+            if (node == NULL)
+            {
+                return NULL;
+            }
+        } while (!head.compare_exchange_weak(oldHead, (uintptr_t)node->next.load() | nextTag(oldHead)));
+        return node;
+    }
+};
+
+#endif
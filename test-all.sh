@@ -49,7 +49,7 @@ make clean
 # echo                                                                     >> $REPORT
 echo -n -e "DS\tTC\tSGMT\tNUM_TXN\t"     >> $REPORT
 echo -n -e "TXN_SIZ\tTHRD_CT\tTIME\tABRTS"                   >> $REPORT
-echo -e "\tPREP\tSHARED\tTOTAL"                   >> $REPORT
+echo -e "\tPREP\tSHARED\tTOTAL\tCFREE"             >> $REPORT
 
 # More grepping to get data that will be useful to print out
 NUM_TXN=$(grep "NUM_TRANSACTIONS" define.hpp | grep "[0-9]*" -o)
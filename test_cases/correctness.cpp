@@ -0,0 +1,724 @@
+// CORRECTNESS
+// Checks the values transactions commit, rather than timing them.
+// Build it like a test case, for a single engine, for example:
+// make DATA_STRUCTURE=SEGMENTVEC MAIN=test_cases/correctness.cpp
+// Build it again with DEFINES="|WAIT_FREE" to check the wait-free paths.
+// Prints a line per check, and exits with the number of checks that failed.
+
+#include "main.hpp"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../asyncExecutor.hpp"
+#include "../engine.hpp"
+#include "../transactionBuilder.hpp"
+#include "../transactionPlan.hpp"
+
+#ifdef SEGMENTVEC
+typedef TransactionalVector TestVector;
+#endif
+#ifdef COMPACTVEC
+typedef CompactVector TestVector;
+#endif
+#ifdef BOOSTEDVEC
+typedef BoostedVector TestVector;
+#endif
+#ifdef STMVEC
+typedef GCCSTMVector TestVector;
+#endif
+#ifdef COARSEVEC
+typedef CoarseTransVector TestVector;
+#endif
+#ifdef STOVEC
+typedef STOVector TestVector;
+#endif
+
+// The number of checks that failed so far.
+static int failures = 0;
+
+static void check(const char *name, bool passed)
+{
+	std::cout << (passed ? "PASS\t" : "FAIL\t") << name << "\n";
+	if (!passed)
+	{
+		failures++;
+	}
+}
+
+static Operation makeOp(Operation::OpType type, size_t index = 0, VAL val = 0)
+{
+	Operation op;
+	op.type = type;
+	op.index = index;
+	op.val = val;
+	op.expected = UNSET;
+	op.ret = UNSET;
+	return op;
+}
+
+// Run a transaction to completion and report whether it committed.
+// Descriptors stay referenced from the vectors they ran on, so neither they nor their operations are ever freed.
+static bool run(TestVector *vector, Desc *desc)
+{
+#ifdef BOOSTEDVEC
+	return vector->executeTransaction(desc);
+#else
+	vector->executeTransaction(desc);
+	return desc->status.load() == Desc::TxStatus::committed;
+#endif
+}
+
+// Read the size of a vector.
+static size_t sizeOf(TestVector *vector)
+{
+	Operation *op = new Operation[1];
+	op[0] = makeOp(Operation::OpType::size);
+	run(vector, new Desc(1, op));
+	// Size results go in index.
+	return op[0].index;
+}
+
+// Read the elements of a vector, one transaction each.
+static std::vector<VAL> contentsOf(TestVector *vector)
+{
+	std::vector<VAL> values(sizeOf(vector));
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		Operation *op = new Operation[1];
+		op[0] = makeOp(Operation::OpType::read, i);
+		run(vector, new Desc(1, op));
+		values[i] = op[0].ret;
+	}
+	return values;
+}
+
+// Run body(thread) on THREAD_COUNT threads, each set up to run transactions on engine.
+static void runThreads(Engine *engine, const std::function<void(size_t thread)> &body)
+{
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < THREAD_COUNT; t++)
+	{
+		threads.emplace_back([engine, &body, t]() {
+			engine->threadInit();
+			body(t);
+			engine->threadFinish();
+		});
+	}
+	for (std::thread &thread : threads)
+	{
+		thread.join();
+	}
+}
+
+// Fill an engine's vector with count copies of val.
+static void fill(Engine *engine, size_t count, VAL val)
+{
+	Region region;
+	TransactionBuilder fill(region, count + 1);
+	fill.reserve(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		fill.pushBack(val);
+	}
+	fill.execute(*engine);
+}
+
+// Transactions run from a plan commit the same values as the same operations run without one.
+static void checkPlans()
+{
+	TestVector *plain = new TestVector();
+	TestVector *planned = new TestVector();
+	std::minstd_rand rng(7);
+	size_t size = 0;
+	bool same = true;
+	for (size_t t = 0; t < 2000; t++)
+	{
+		unsigned int count = 1 + rng() % 6;
+		Operation::OpType types[6];
+		Operation *ops = new Operation[count];
+		Operation *plannedOps = new Operation[count];
+		for (unsigned int i = 0; i < count; i++)
+		{
+			unsigned int pick = rng() % 10;
+			types[i] = pick < 3 ? Operation::OpType::pushBack : pick < 5 ? Operation::OpType::popBack : pick < 7 ? Operation::OpType::read : pick < 9 ? Operation::OpType::write : Operation::OpType::size;
+			ops[i] = makeOp(types[i], rng() % (size + 2), rng() % 1000);
+			// The plan fills in the types.
+			plannedOps[i] = makeOp(Operation::OpType::reserve, ops[i].index, ops[i].val);
+		}
+		// Plans must outlive their descriptors, which are never freed.
+		TransactionPlan *plan = new TransactionPlan(types, count);
+		bool committed = run(plain, new Desc(count, ops));
+		if (committed != run(planned, new Desc(*plan, plannedOps)))
+		{
+			same = false;
+			continue;
+		}
+		for (unsigned int i = 0; committed && i < count; i++)
+		{
+			same &= ops[i].type != Operation::OpType::size || ops[i].index == plannedOps[i].index;
+			same &= (ops[i].type != Operation::OpType::read && ops[i].type != Operation::OpType::popBack) || ops[i].ret == plannedOps[i].ret;
+		}
+		size = sizeOf(plain);
+	}
+	check("plans commit the same values as plain operations", same && contentsOf(plain) == contentsOf(planned));
+}
+
+// Every transaction submitted to an executor runs, and its callback runs before its completion is ready.
+static void checkAsync()
+{
+	const size_t count = 1000;
+	TestVector *vector = new TestVector();
+	Operation *ops = new Operation[count];
+	std::atomic<bool> *called = new std::atomic<bool>[count];
+	std::vector<Completion *> completions;
+	size_t committed = 0;
+	bool ordered = true;
+	{
+		AsyncExecutor<TestVector> executor(vector, 2);
+		for (size_t i = 0; i < count; i++)
+		{
+			called[i].store(false);
+			ops[i] = makeOp(Operation::OpType::pushBack, 0, i + 1);
+			completions.push_back(new Completion([called](Desc *desc, bool) { called[desc->ops[0].val - 1].store(true); }));
+			executor.submit(new Desc(1, &ops[i]), *completions[i]);
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			committed += completions[i]->wait();
+			ordered &= called[i].load();
+		}
+	}
+	for (Completion *completion : completions)
+	{
+		delete completion;
+	}
+	check("async executor runs callbacks before completing", ordered);
+	check("async executor commits every transaction", committed == count && sizeOf(vector) == count);
+}
+
+#if defined(SEGMENTVEC) || defined(COMPACTVEC) || defined(BOOSTEDVEC)
+static bool run(TestVector *vector, const std::vector<Operation> &ops)
+{
+	Operation *copies = new Operation[ops.size()];
+	std::copy(ops.begin(), ops.end(), copies);
+	return run(vector, new Desc(ops.size(), copies));
+}
+
+// Transactions that push onto one vector and pop off another, both in one transaction.
+// Every commit moves one element, so the two sizes always add up to the same total.
+static void checkGroupedPushPop()
+{
+	const size_t initial = 64;
+	const size_t iterations = 3000;
+	TestVector *vectors[2] = {transVector, new TestVector()};
+	for (TestVector *vector : vectors)
+	{
+		std::vector<Operation> fill;
+		for (size_t i = 0; i < initial; i++)
+		{
+			fill.push_back(makeOp(Operation::OpType::pushBack, 0, i + 1));
+		}
+		run(vector, fill);
+	}
+
+	// Commits that pushed onto each vector.
+	std::atomic<size_t> pushes[2];
+	pushes[0].store(0);
+	pushes[1].store(0);
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < THREAD_COUNT; t++)
+	{
+		threads.emplace_back([&, t]() {
+			threadAllocatorInit();
+			for (size_t i = 0; i < iterations; i++)
+			{
+				// Alternate directions, so both vectors keep elements to pop.
+				size_t to = (i + t) % 2;
+				Operation *push = new Operation[1];
+				push[0] = makeOp(Operation::OpType::pushBack, 0, t * iterations + i + 1);
+				Operation *pop = new Operation[1];
+				pop[0] = makeOp(Operation::OpType::popBack);
+				std::vector<OpGroup> groups = {{vectors[to], 1, push}, {vectors[1 - to], 1, pop}};
+				if (run(vectors[0], new Desc(groups)))
+				{
+					pushes[to]++;
+				}
+			}
+			threadAllocatorFinish();
+		});
+	}
+	for (std::thread &thread : threads)
+	{
+		thread.join();
+	}
+
+	size_t sizes[2] = {sizeOf(vectors[0]), sizeOf(vectors[1])};
+	check("grouped push/pop keeps the total size", sizes[0] + sizes[1] == 2 * initial);
+	check("grouped push/pop sizes match the commits", sizes[0] == initial + pushes[0].load() - pushes[1].load() && sizes[1] == initial + pushes[1].load() - pushes[0].load());
+}
+
+// A transaction with two groups on one vector aborts without running either.
+static void checkSharedGroups()
+{
+	TestVector *vector = new TestVector();
+	Operation *first = new Operation[1];
+	first[0] = makeOp(Operation::OpType::pushBack, 0, 1);
+	Operation *second = new Operation[1];
+	second[0] = makeOp(Operation::OpType::pushBack, 0, 2);
+	std::vector<OpGroup> groups = {{vector, 1, first}, {vector, 1, second}};
+	Desc *desc = new Desc(groups);
+	bool committed = run(vector, desc);
+	check("groups sharing a vector abort", !committed && desc->abortCause.load() == AbortCause::invalid && sizeOf(vector) == 0);
+}
+#endif
+
+// Builders hand back the results of their operations.
+static void checkBuilders(Engine *engine)
+{
+	FixedTransactionBuilder<8> fixed;
+	fixed.reserve(16).pushBack(7).pushBack(9).pushBack(11);
+	SizeResult pushed = fixed.size();
+	ValueResult popped = fixed.popBack();
+	bool first = fixed.execute(*engine);
+	// Starts with room for one operation, so it has to grow.
+	Region region;
+	TransactionBuilder grown(region, 1);
+	ValueResult before = grown.read(0);
+	grown.write(0, 5);
+	ValueResult after = grown.read(0);
+	SizeResult size = grown.size();
+	bool second = grown.execute(*engine);
+	check("fixed builder returns its results", first && pushed.get() == 3 && popped.get() == 11);
+	check("region builder grows and returns its results", second && before.get() == 7 && after.get() == 5 && size.get() == 2);
+}
+
+// Compare writes only write when they find the expected value, and concurrent increments built on them all land.
+static void checkCompareWrite(Engine *engine)
+{
+	fill(engine, 16, 0);
+	FixedTransactionBuilder<1> miss;
+	ValueResult missed = miss.compareWrite(3, 5, 9);
+	bool skipped = miss.execute(*engine);
+	AbortCause cause = AbortCause::none;
+	FixedTransactionBuilder<1> strict;
+	strict.compareWriteOrAbort(3, 5, 9);
+	bool aborted = !strict.execute(*engine, RetryPolicy(), &cause);
+	FixedTransactionBuilder<1> hit;
+	ValueResult found = hit.compareWrite(3, 0, 9);
+	bool written = hit.execute(*engine);
+	FixedTransactionBuilder<1> read;
+	ValueResult value = read.read(3);
+	read.execute(*engine);
+	check("compare write skips a mismatch", skipped && missed.get() == 0);
+	check("strict compare write aborts on a mismatch", aborted && cause == AbortCause::compareFailed);
+	check("compare write writes on a match", written && found.get() == 0 && value.get() == 9);
+
+	const size_t increments = 1000;
+	runThreads(engine, [engine, increments](size_t) {
+		for (size_t i = 0; i < increments; i++)
+		{
+			while (true)
+			{
+				FixedTransactionBuilder<1> read;
+				ValueResult current = read.read(10);
+				if (!read.execute(*engine))
+				{
+					continue;
+				}
+				FixedTransactionBuilder<1> write;
+				write.compareWriteOrAbort(10, current.get(), current.get() + 1);
+				if (write.execute(*engine))
+				{
+					break;
+				}
+			}
+		}
+	});
+	FixedTransactionBuilder<1> total;
+	ValueResult counter = total.read(10);
+	total.execute(*engine);
+	check("compare write increments all land", counter.get() == THREAD_COUNT * increments);
+}
+
+// Commutative updates merge within a transaction, and none are lost between concurrent ones.
+static void checkFetch(Engine *engine)
+{
+	fill(engine, 16, 0);
+	FixedTransactionBuilder<3> init;
+	init.write(11, 1000000);
+	init.execute(*engine);
+	FixedTransactionBuilder<4> merged;
+	merged.fetchAdd(3, 5).fetchAdd(3, 7).fetchXor(4, 6).fetchMax(5, 9);
+	bool committed = merged.execute(*engine);
+	FixedTransactionBuilder<3> read;
+	ValueResult added = read.read(3);
+	ValueResult xored = read.read(4);
+	ValueResult maxed = read.read(5);
+	read.execute(*engine);
+	check("fetch updates merge within a transaction", committed && added.get() == 12 && xored.get() == 6 && maxed.get() == 9);
+#if defined(SEGMENTVEC) || defined(COMPACTVEC) || defined(BOOSTEDVEC)
+	// Only the engines that merge updates reject reading the element too. The others just run the operations in order.
+	FixedTransactionBuilder<2> mixed;
+	mixed.fetchAdd(6, 1);
+	mixed.read(6);
+	check("fetch update and read of one element abort", !mixed.execute(*engine));
+#endif
+
+	const size_t updates = 2000;
+	runThreads(engine, [engine, updates](size_t thread) {
+		for (size_t i = 0; i < updates; i++)
+		{
+			VAL val = thread * updates + i + 1;
+			FixedTransactionBuilder<3> update;
+			update.fetchAdd(10, 1).fetchMin(11, val).fetchMax(12, val);
+			update.execute(*engine, RetryPolicy(UINT32_MAX));
+		}
+	});
+	FixedTransactionBuilder<3> total;
+	ValueResult sum = total.read(10);
+	ValueResult low = total.read(11);
+	ValueResult high = total.read(12);
+	total.execute(*engine);
+	check("concurrent fetch updates all land", sum.get() == THREAD_COUNT * updates && low.get() == 1 && high.get() == THREAD_COUNT * updates);
+}
+
+// Retry policies report why the last attempt aborted, and keep contended transactions going until they commit.
+static void checkRetry(Engine *engine)
+{
+	// The lock-based engines leave the operations before an abort in place, so these abort on their first operation.
+	AbortCause cause = AbortCause::none;
+	FixedTransactionBuilder<1> pop;
+	pop.popBack();
+	bool aborted = !pop.execute(*engine, RetryPolicy(3, std::chrono::microseconds(10)).retryOn(AbortCause::outOfBounds), &cause);
+	check("retry gives up after its attempts", aborted && cause == AbortCause::outOfBounds);
+	cause = AbortCause::contention;
+	FixedTransactionBuilder<2> push;
+	push.pushBack(1).pushBack(2);
+	bool committed = push.execute(*engine, RetryPolicy(), &cause);
+	check("retry reports no cause on commit", committed && cause == AbortCause::none);
+	FixedTransactionBuilder<1> past;
+	past.read(5);
+	aborted = !past.execute(*engine, RetryPolicy().retryOn(AbortCause::outOfBounds, false), &cause);
+	check("retry reports an out of bounds read", aborted && cause == AbortCause::outOfBounds);
+
+	const size_t updates = 2000;
+	std::atomic<size_t> failed(0);
+	runThreads(engine, [engine, updates, &failed](size_t) {
+		for (size_t i = 0; i < updates; i++)
+		{
+			FixedTransactionBuilder<2> update;
+			update.fetchAdd(0, 1).write(1, i + 1);
+			if (!update.execute(*engine, RetryPolicy(UINT32_MAX)))
+			{
+				failed++;
+			}
+		}
+	});
+	FixedTransactionBuilder<1> total;
+	ValueResult sum = total.read(0);
+	total.execute(*engine);
+	check("retried transactions all commit", failed.load() == 0 && sum.get() == 1 + THREAD_COUNT * updates);
+}
+
+// Deques take values at both ends, and lose none under concurrent pushes and pops.
+static void checkDeque(Engine *engine)
+{
+	AbortCause cause = AbortCause::none;
+	if (!engine->makeDeque(8))
+	{
+		FixedTransactionBuilder<1> front;
+		front.pushFront(5);
+		check("engines without a deque reject front operations", !front.execute(*engine, RetryPolicy(), &cause) && cause == AbortCause::invalid);
+		return;
+	}
+	FixedTransactionBuilder<4> ends;
+	ends.pushBack(1).pushFront(2);
+	ValueResult first = ends.read(0);
+	ValueResult second = ends.read(1);
+	bool pushed = ends.execute(*engine);
+	FixedTransactionBuilder<2> pops;
+	ValueResult front = pops.popFront();
+	ValueResult back = pops.popBack();
+	bool popped = pops.execute(*engine);
+	check("deque pushes and pops at both ends", pushed && first.get() == 2 && second.get() == 1 && popped && front.get() == 2 && back.get() == 1);
+
+	// Threads push onto the back and pop off the front, so every value pushed is popped at most once.
+	const size_t count = 2000;
+	std::atomic<uint64_t> pushedSum(0);
+	std::atomic<uint64_t> poppedSum(0);
+	runThreads(engine, [engine, count, &pushedSum, &poppedSum](size_t thread) {
+		for (size_t i = 0; i < count; i++)
+		{
+			FixedTransactionBuilder<1> step;
+			if (i % 2 == 0)
+			{
+				VAL val = thread * count + i + 1;
+				step.pushBack(val);
+				if (step.execute(*engine, RetryPolicy(1000)))
+				{
+					pushedSum += val;
+				}
+			}
+			else
+			{
+				ValueResult val = step.popFront();
+				if (step.execute(*engine, RetryPolicy(1000)))
+				{
+					poppedSum += val.get();
+				}
+			}
+		}
+	});
+	uint64_t rest = 0;
+	while (true)
+	{
+		FixedTransactionBuilder<1> drain;
+		ValueResult val = drain.popFront();
+		if (!drain.execute(*engine))
+		{
+			break;
+		}
+		rest += val.get();
+	}
+	check("deque loses no values", pushedSum.load() == poppedSum.load() + rest);
+	// Checked last, since the lock-based engines keep the pushes before the one that overflows.
+	FixedTransactionBuilder<9> over;
+	for (VAL i = 0; i < 9; i++)
+	{
+		over.pushFront(i + 1);
+	}
+	check("deque rejects pushes past its capacity", !over.execute(*engine, RetryPolicy(), &cause) && cause == AbortCause::outOfBounds);
+}
+
+// Logs keep every append, and each thread's appends in the order it made them.
+static void checkLog(Engine *engine)
+{
+	// Engines without a log have nothing to check.
+	if (!engine->makeLog())
+	{
+		return;
+	}
+	AbortCause cause = AbortCause::none;
+	FixedTransactionBuilder<2> mixed;
+	mixed.pushBack(1).read(0);
+	check("log rejects transactions that do more than push", !mixed.execute(*engine, RetryPolicy(), &cause) && cause == AbortCause::invalid);
+
+	// Values carry their thread in the high digits, and their position in the low ones.
+	const size_t count = 20000;
+	const size_t split = 1000000;
+	std::atomic<bool> done(false);
+	size_t seen = 0;
+	bool ordered = true;
+	std::thread reader([engine, &done, &seen, &ordered, split]() {
+		size_t cursor = 0;
+		VAL values[64];
+		std::vector<size_t> last(THREAD_COUNT, 0);
+		while (true)
+		{
+			bool finished = done.load();
+			size_t read = engine->readLog(cursor, values, 64);
+			for (size_t i = 0; i < read; i++)
+			{
+				ordered &= values[i] % split == last[values[i] / split] + 1;
+				last[values[i] / split] = values[i] % split;
+			}
+			seen += read;
+			if (read == 0 && finished)
+			{
+				break;
+			}
+		}
+	});
+	runThreads(engine, [engine, count, split](size_t thread) {
+		for (size_t i = 0; i < count; i += 5)
+		{
+			FixedTransactionBuilder<5> append;
+			for (size_t j = 0; j < 5; j++)
+			{
+				append.pushBack(thread * split + i + j + 1);
+			}
+			append.execute(*engine);
+		}
+	});
+	done.store(true);
+	reader.join();
+	check("log keeps every append in order", ordered && seen == THREAD_COUNT * count);
+}
+
+// Single pushes and pops lose no values. The compact vector pairs them off through its elimination array.
+static void checkElimination(Engine *engine)
+{
+	const size_t count = 20000;
+	std::atomic<uint64_t> pushedSum(0);
+	std::atomic<uint64_t> poppedSum(0);
+	runThreads(engine, [engine, count, &pushedSum, &poppedSum](size_t thread) {
+		for (size_t i = 0; i < count; i++)
+		{
+			FixedTransactionBuilder<1> step;
+			if ((i + thread) % 2 == 0)
+			{
+				VAL val = thread * count + i + 1;
+				step.pushBack(val);
+				if (step.execute(*engine))
+				{
+					pushedSum += val;
+				}
+			}
+			else
+			{
+				ValueResult val = step.popBack();
+				if (step.execute(*engine))
+				{
+					poppedSum += val.get();
+				}
+			}
+		}
+	});
+	uint64_t rest = 0;
+	while (true)
+	{
+		FixedTransactionBuilder<1> drain;
+		ValueResult val = drain.popBack();
+		if (!drain.execute(*engine))
+		{
+			break;
+		}
+		rest += val.get();
+	}
+	check("single pushes and pops lose no values", pushedSum.load() == poppedSum.load() + rest);
+}
+
+// Snapshots see whole transactions only, while writers keep running.
+static void checkSnapshots(Engine *engine)
+{
+	// Writers pair element i with element count - 1 - i, and keep each pair summing to 2000.
+	const size_t count = 20000;
+	std::vector<VAL> values(count, 1000);
+	uint64_t result = 0;
+	// Engines without consistent snapshots have nothing to check.
+	if (!engine->bulkLoad(values.data(), count) || !engine->reduce(Reduction::sum, result))
+	{
+		return;
+	}
+	std::atomic<bool> stop(false);
+	std::vector<std::thread> writers;
+	for (size_t t = 0; t < 2; t++)
+	{
+		writers.emplace_back([engine, &stop, count, t]() {
+			engine->threadInit();
+			std::minstd_rand rng(t + 1);
+			while (!stop.load())
+			{
+				size_t i = rng() % (count / 2);
+				VAL val = rng() % 2000;
+				FixedTransactionBuilder<2> pair;
+				pair.write(i, val).write(count - 1 - i, 2000 - val);
+				pair.execute(*engine);
+			}
+			engine->threadFinish();
+		});
+	}
+	bool consistent = true;
+	for (size_t round = 0; round < 50; round++)
+	{
+		uint64_t sum = 0;
+		uint64_t elements = 0;
+		consistent &= engine->reduce(Reduction::sum, sum) && sum == count * 1000;
+		consistent &= engine->reduce(Reduction::count, elements) && elements == count;
+		std::mutex lock;
+		uint64_t visited = 0;
+		uint64_t visitedSum = 0;
+		consistent &= engine->forEach([&](size_t, const VAL *values, size_t count) {
+			std::lock_guard<std::mutex> guard(lock);
+			for (size_t i = 0; i < count; i++)
+			{
+				visitedSum += values[i];
+			}
+			visited += count;
+		});
+		consistent &= visited == count && visitedSum == count * 1000;
+	}
+	stop.store(true);
+	for (std::thread &writer : writers)
+	{
+		writer.join();
+	}
+	// Each count takes its own snapshot, so they only agree once the writers stop.
+	// Every pair then has as many elements below 1000 as above it.
+	uint64_t low = 0;
+	uint64_t high = 0;
+	engine->countIf([](VAL val) { return val < 1000; }, low);
+	engine->countIf([](VAL val) { return val > 1000; }, high);
+	check("snapshots only see whole transactions", consistent);
+	check("predicate counts match", low == high && low != 0);
+}
+
+// Get the bytes held by regions, which hold the maps of sets and the pages of transactions.
+static size_t regionBytes(Engine *engine)
+{
+	for (const MemoryStats &stats : engine->memoryStats())
+	{
+		if (std::string(stats.name) == "Region")
+		{
+			return stats.inUseBytes;
+		}
+	}
+	return 0;
+}
+
+// Memory stays flat across many transactions, since each one's set and pages map are recycled once it finishes.
+static void checkMemory(Engine *engine)
+{
+	const size_t count = 256;
+	const size_t writes = 64;
+	fill(engine, count, 1);
+	// Enough writes that every set outgrows its inline entries, spread over several pages.
+	auto batch = [engine, count, writes](size_t transactions) {
+		for (size_t t = 0; t < transactions; t++)
+		{
+			FixedTransactionBuilder<writes> step;
+			for (size_t i = 0; i < writes; i++)
+			{
+				step.write((t + i * (count / writes)) % count, t + 1);
+			}
+			step.execute(*engine);
+		}
+	};
+	batch(1000);
+	size_t before = regionBytes(engine);
+	batch(20000);
+	size_t after = regionBytes(engine);
+	// Whatever is still waiting to be reclaimed comes and goes, so allow for a little growth.
+	check("memory stays flat across transactions", after <= before + before / 2 + REGION_CHUNK_SIZE);
+}
+
+int main(void)
+{
+	allocatorInit();
+	threadAllocatorInit();
+
+	checkPlans();
+	checkAsync();
+#if defined(SEGMENTVEC) || defined(COMPACTVEC) || defined(BOOSTEDVEC)
+	checkGroupedPushPop();
+	checkSharedGroups();
+#endif
+
+	// Each check gets a fresh vector. Engines are never freed, same as their descriptors.
+	std::vector<void (*)(Engine *)> checks = {checkBuilders, checkCompareWrite, checkFetch, checkRetry, checkDeque, checkLog, checkElimination, checkSnapshots, checkMemory};
+	for (void (*check)(Engine *) : checks)
+	{
+		Engine *engine = createEngine(ENGINE_NAME);
+		engine->threadInit();
+		check(engine);
+		engine->threadFinish();
+	}
+
+	std::cout << failures << " failed\n";
+	return failures;
+}
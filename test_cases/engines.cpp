@@ -0,0 +1,136 @@
+// ENGINE COMPARISON
+// RANDOM WRITES, ONE BINARY
+// Runs the random write benchmark against each engine named on the command line, or every engine built in.
+// Build with the makefile's ENGINES option, for example:
+// make ENGINES="SEGMENTVEC COMPACTVEC BOOSTEDVEC" MAIN=test_cases/engines.cpp
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "../engine.hpp"
+#include "../transactionBuilder.hpp"
+
+#define TIME_UNIT nanoseconds
+
+// Fill the vector with random values.
+static void preinsert(Engine *engine)
+{
+	std::vector<VAL> values(NUM_TRANSACTIONS);
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		VAL val = UNSET;
+		// Ensure we never get an UNSET.
+		while (val == UNSET)
+		{
+			val = rand() % std::numeric_limits<VAL>::max();
+		}
+		values[i] = val;
+	}
+	// Engines without a bulk load push the values in one transaction instead.
+	bool loaded = engine->bulkLoad(values.data(), values.size());
+
+	FixedTransactionBuilder<1> reserve;
+	reserve.reserve(NUM_TRANSACTIONS).execute(*engine);
+	if (loaded)
+	{
+		return;
+	}
+
+	std::vector<Operation> pushOps(NUM_TRANSACTIONS);
+	for (size_t i = 0; i < pushOps.size(); i++)
+	{
+		pushOps[i].type = Operation::OpType::pushBack;
+		pushOps[i].val = values[i];
+	}
+	if (!engine->execute(pushOps.data(), pushOps.size()))
+	{
+		std::cerr << engine->name() << ": Preinsert failed." << std::endl;
+	}
+}
+
+// Run a share of the transactions on one thread.
+static void executeTransactions(Engine *engine, std::vector<Operation> *transactions, int threadNum, size_t *aborts)
+{
+	engine->threadInit();
+	size_t start = NUM_TRANSACTIONS * threadNum / THREAD_COUNT;
+	size_t end = NUM_TRANSACTIONS * (threadNum + 1) / THREAD_COUNT;
+	for (size_t i = start; i < end; i++)
+	{
+		if (!engine->execute(&transactions->at(i * TRANSACTION_SIZE), TRANSACTION_SIZE))
+		{
+			(*aborts)++;
+		}
+	}
+	engine->threadFinish();
+}
+
+static void benchmark(Engine *engine)
+{
+	preinsert(engine);
+
+	// All operations are writes.
+	std::vector<Operation> transactions(NUM_TRANSACTIONS * TRANSACTION_SIZE);
+	for (size_t i = 0; i < transactions.size(); i++)
+	{
+		transactions[i].type = Operation::OpType::write;
+		transactions[i].val = rand() % std::numeric_limits<VAL>::max();
+		transactions[i].index = rand() % NUM_TRANSACTIONS;
+	}
+
+	std::thread threads[THREAD_COUNT];
+	size_t aborts[THREAD_COUNT] = {};
+	auto start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < THREAD_COUNT; i++)
+	{
+		threads[i] = std::thread(executeTransactions, engine, &transactions, i, &aborts[i]);
+	}
+	for (size_t i = 0; i < THREAD_COUNT; i++)
+	{
+		threads[i].join();
+	}
+	auto finish = std::chrono::high_resolution_clock::now();
+
+	size_t abortCount = 0;
+	for (size_t i = 0; i < THREAD_COUNT; i++)
+	{
+		abortCount += aborts[i];
+	}
+
+	std::cout << engine->name() << "\t" << NUM_TRANSACTIONS << "\t";
+	std::cout << TRANSACTION_SIZE << "\t" << THREAD_COUNT << "\t";
+	std::cout << std::chrono::duration_cast<std::chrono::TIME_UNIT>(finish - start).count();
+	std::cout << "\t" << abortCount << "\n";
+}
+
+int main(int argc, char **argv)
+{
+	// Seed the random number generator.
+	srand(time(NULL));
+
+	std::vector<const char *> names;
+	for (int i = 1; i < argc; i++)
+	{
+		names.push_back(argv[i]);
+	}
+	if (names.empty())
+	{
+		names = engineNames();
+	}
+
+	for (const char *name : names)
+	{
+		Engine *engine = createEngine(name);
+		if (engine == NULL)
+		{
+			std::cerr << name << " is not built into this binary." << std::endl;
+			continue;
+		}
+		benchmark(engine);
+	}
+	return 0;
+}
@@ -24,23 +24,30 @@ CoarseTransVector *transVector = new CoarseTransVector();
 STOVector *transVector = new STOVector();
 #endif
 
+// The number of threads started by the latest threadRunner call.
+size_t runningThreads = THREAD_COUNT;
+
 // Input: 1- Array of threads that will execute a fucntion.
 //        2- A function pointer to that function.
-void threadRunner(std::thread *threads, void function(int threadNum))
+//        3- The number of threads to run. The array must hold at least this many.
+void threadRunner(std::thread *threads, void function(int threadNum), size_t threadCount)
 {
+	runningThreads = threadCount;
 	// Start our threads.
-	for (size_t i = 0; i < THREAD_COUNT; i++)
+	for (size_t i = 0; i < threadCount; i++)
 	{
 		threads[i] = std::thread(function, i);
 	}
 
 	// Set thread affinity.
-	for (unsigned i = 0; i < THREAD_COUNT; ++i)
+	// Wrap around if there are more threads than CPUs.
+	unsigned cpus = std::thread::hardware_concurrency();
+	for (unsigned i = 0; i < threadCount; ++i)
 	{
 		// Create a cpu_set_t object representing a set of CPUs. Clear it and mark only CPU i as set.
 		cpu_set_t cpuset;
 		CPU_ZERO(&cpuset);
-		CPU_SET(i, &cpuset);
+		CPU_SET(cpus == 0 ? i : i % cpus, &cpuset);
 		int rc = pthread_setaffinity_np(threads[i].native_handle(), sizeof(cpu_set_t), &cpuset);
 		if (rc != 0)
 		{
@@ -49,7 +56,7 @@ void threadRunner(std::thread *threads, void function(int threadNum))
 	}
 
 	// Wait for all threads to complete.
-	for (size_t i = 0; i < THREAD_COUNT; i++)
+	for (size_t i = 0; i < threadCount; i++)
 	{
 		threads[i].join();
 	}
@@ -61,11 +68,11 @@ void threadRunner(std::thread *threads, void function(int threadNum))
 void executeTransactions(int threadNum)
 {
 	// Initialize the allocators.
-	threadAllocatorInit(threadNum);
+	threadAllocatorInit();
 
 	// Each thread is allocated an interval to work on
-	int start = transactions->size() / THREAD_COUNT * threadNum;
-	int end = transactions->size() / THREAD_COUNT * (threadNum + 1);
+	int start = transactions->size() * threadNum / runningThreads;
+	int end = transactions->size() * (threadNum + 1) / runningThreads;
 
 	for (int i = start; i < end; i++)
 	{
@@ -79,12 +86,15 @@ void executeTransactions(int threadNum)
 		}
 #endif
 	}
+
+	// Hand this thread's cached objects back to the allocators.
+	threadAllocatorFinish();
 }
 
 void executeRangedTransactions(int threadNum)
 {
 	// Initialize the allocators.
-	threadAllocatorInit(threadNum);
+	threadAllocatorInit();
 
 	Desc *desc = transactions->at(threadNum);
 #ifndef BOOSTEDVEC
@@ -95,16 +105,48 @@ void executeRangedTransactions(int threadNum)
 		abortCount.fetch_add(1);
 	}
 #endif
+
+	// Hand this thread's cached objects back to the allocators.
+	threadAllocatorFinish();
 }
 
 // Prepushes a bunch of objects into the vector
-void preinsert(int threadNum)
+void preinsert([[maybe_unused]] int threadNum)
 {
-	// Initialize the allocators.
-	threadAllocatorInit(threadNum);
+	// The test cases run this on the main thread, so it does not attach to the thread registry.
+	// Doing so would fault in a worker's share of the allocators on the wrong thread.
 
 	int opsPerThread = NUM_TRANSACTIONS / THREAD_COUNT;
 
+#ifndef STOVEC
+	// The vector is still empty and unshared, so the first call bulk loads every thread's share at once.
+	// The later calls find their share already in.
+	if (threadNum != 0)
+	{
+		return;
+	}
+	size_t count = (size_t)opsPerThread * THREAD_COUNT;
+	VAL *values = new VAL[count];
+	for (size_t j = 0; j < count; j++)
+	{
+		// Push random values into the vector.
+		VAL val = UNSET;
+		// Ensure we never get an UNSET.
+		while (val == UNSET)
+		{
+			val = rand() % std::numeric_limits<VAL>::max();
+		}
+		values[j] = val;
+	}
+	bool loaded = transVector->bulkLoad(values, count, THREAD_COUNT);
+	delete[] values;
+	if (!loaded)
+	{
+		printf("Preinsert failed.\n");
+		return;
+	}
+#endif
+
 	// Ensure reserves have already completed to prevent them from affecting performance.
 	Operation *reserveOp = new Operation[1];
 	reserveOp->type = Operation::OpType::reserve;
@@ -112,6 +154,7 @@ void preinsert(int threadNum)
 	Desc *reserveDesc = new Desc(1, reserveOp);
 	transVector->executeTransaction(reserveDesc);
 
+#ifdef STOVEC
 	// A list of operations for the current thread.
 	Operation *pushOps = new Operation[opsPerThread];
 
@@ -134,20 +177,13 @@ void preinsert(int threadNum)
 	// Create a transaction containing the these operations.
 	Desc *pushDesc = new Desc(opsPerThread, pushOps);
 
-// Execute the transaction.
-#ifndef BOOSTEDVEC
+	// Execute the transaction.
 	transVector->executeTransaction(pushDesc);
 	if (pushDesc->status.load() != Desc::TxStatus::committed)
 	{
 		printf("Preinsert failed.\n");
 		return;
 	}
-#else
-	if (!transVector->executeTransaction(pushDesc))
-	{
-		printf("Preinsert failed.\n");
-		return;
-	}
 #endif
 	return;
 }
@@ -169,6 +205,19 @@ size_t countAborts([[maybe_unused]] std::vector<Desc *> *transactions)
 #endif
 }
 
+size_t countConflictFree([[maybe_unused]] std::vector<Desc *> *transactions)
+{
+	size_t retVal = 0;
+#if defined(SEGMENTVEC) && defined(CONFLICT_FREE_READS)
+	for (size_t i = 0; i < transactions->size(); i++)
+	{
+		if (transactions->at(i)->isConflictFree)
+			retVal++;
+	}
+#endif
+	return retVal;
+}
+
 #ifdef METRICS
 std::chrono::TIME_UNIT measurePreprocessTime([[maybe_unused]] std::vector<Desc *> *transactions)
 {
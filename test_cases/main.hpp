@@ -18,6 +18,9 @@
 #include <sys/resource.h>
 #include <unistd.h>
 
+// The test cases are built against a single engine.
+using namespace ENGINE_NAMESPACE;
+
 #ifdef SEGMENTVEC
 #include "../transVector.hpp"
 extern TransactionalVector *transVector;
@@ -55,7 +58,9 @@ void executeTransactions(int threadNum);
 
 void executeRangedTransactions(int threadNum);
 
-void threadRunner(std::thread *threads, void function(int threadNum));
+extern size_t runningThreads;
+
+void threadRunner(std::thread *threads, void function(int threadNum), size_t threadCount = THREAD_COUNT);
 
 void preinsert(int threadNum);
 
@@ -63,6 +68,10 @@ void createTransactions(int threadNum);
 
 size_t countAborts(std::vector<Desc *> *transactions);
 
+// Count the transactions the vector routed to conflict-free reads.
+// Always 0 for vectors without them.
+size_t countConflictFree(std::vector<Desc *> *transactions);
+
 #ifdef METRICS
 std::chrono::TIME_UNIT measurePreprocessTime([[maybe_unused]] std::vector<Desc *> *transactions);
 std::chrono::TIME_UNIT measureSharedTime([[maybe_unused]] std::vector<Desc *> *transactions);
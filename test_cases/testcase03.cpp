@@ -43,7 +43,7 @@ int main(void)
 	setMaxPriority();
 
 	// Pre-fill the allocators.
-	allocatorInit();
+	allocatorInit(THREAD_COUNT, NUM_TRANSACTIONS / THREAD_COUNT, TRANSACTION_SIZE);
 
 	// Reserve the transaction vector, for minor performance gains.
 	transactions->reserve(THREAD_COUNT);
@@ -84,6 +84,7 @@ int main(void)
 	std::cout << "\t" << shared.count();
 	std::cout << "\t" << total.count();
 #endif
+	std::cout << "\t" << countConflictFree(transactions);
 	std::cout << "\n";
 
 	// Report on allocator issues.
@@ -19,9 +19,6 @@ void createTransactions()
 		}
 
 		Desc *desc = new Desc(TRANSACTION_SIZE, ops);
-#ifdef CONFLICT_FREE_READS
-		desc->isConflictFree = true;
-#endif
 		transactions->push_back(desc);
 	}
 }
@@ -36,7 +33,7 @@ int main(void)
 	setMaxPriority();
 
 	// Pre-fill the allocators.
-	allocatorInit();
+	allocatorInit(THREAD_COUNT, NUM_TRANSACTIONS / THREAD_COUNT, TRANSACTION_SIZE);
 
 	// Reserve the transaction vector, for minor performance gains.
 	transactions->reserve(THREAD_COUNT);
@@ -77,6 +74,7 @@ int main(void)
 	std::cout << "\t" << shared.count();
 	std::cout << "\t" << total.count();
 #endif
+	std::cout << "\t" << countConflictFree(transactions);
 	std::cout << "\n";
 
 	// Report on allocator issues.
@@ -6,9 +6,6 @@
 
 void createTransactions()
 {
-#ifdef CONFLICT_FREE_READS
-	bool isConflictFree = true;
-#endif
 	// Prepare to read the entire vector.
 	for (size_t j = 0; j < NUM_TRANSACTIONS; j++)
 	{
@@ -24,10 +21,6 @@ void createTransactions()
 				ops[k].type = Operation::OpType::write;
 				ops[k].val = rand() % rand() % std::numeric_limits<VAL>::max();
 				ops[k].index = rand() % NUM_TRANSACTIONS;
-#ifdef CONFLICT_FREE_READS
-				// If even one operation isn't a read, then we can't execute it in a conflict-free way.
-				isConflictFree = false;
-#endif
 			}
 			else
 			{
@@ -38,9 +31,6 @@ void createTransactions()
 		}
 
 		Desc *desc = new Desc(TRANSACTION_SIZE, ops);
-#ifdef CONFLICT_FREE_READS
-		desc->isConflictFree = isConflictFree;
-#endif
 		transactions->push_back(desc);
 	}
 }
@@ -55,7 +45,7 @@ int main(void)
 	setMaxPriority();
 
 	// Pre-fill the allocators.
-	allocatorInit();
+	allocatorInit(THREAD_COUNT, NUM_TRANSACTIONS / THREAD_COUNT, TRANSACTION_SIZE);
 
 	// Reserve the transaction vector, for minor performance gains.
 	transactions->reserve(THREAD_COUNT);
@@ -96,6 +86,7 @@ int main(void)
 	std::cout << "\t" << shared.count();
 	std::cout << "\t" << total.count();
 #endif
+	std::cout << "\t" << countConflictFree(transactions);
 	std::cout << "\n";
 
 	// Report on allocator issues.
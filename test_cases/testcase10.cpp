@@ -6,9 +6,6 @@
 
 void createTransactions()
 {
-#ifdef CONFLICT_FREE_READS
-	bool isConflictFree = true;
-#endif
 	for (size_t j = 0; j < NUM_TRANSACTIONS; j++)
 	{
 		Operation *ops = new Operation[TRANSACTION_SIZE];
@@ -23,10 +20,6 @@ void createTransactions()
 				ops[k].type = Operation::OpType::write;
 				ops[k].val = rand() % std::numeric_limits<VAL>::max();
 				ops[k].index = rand() % NUM_TRANSACTIONS;
-#ifdef CONFLICT_FREE_READS
-				// If even one operation isn't a read, then we can't execute it in a conflict-free way.
-				isConflictFree = false;
-#endif
 			}
 			else
 			{
@@ -37,9 +30,6 @@ void createTransactions()
 		}
 
 		Desc *desc = new Desc(TRANSACTION_SIZE, ops);
-#ifdef CONFLICT_FREE_READS
-		desc->isConflictFree = isConflictFree;
-#endif
 		transactions->push_back(desc);
 	}
 }
@@ -54,7 +44,7 @@ int main(void)
 	setMaxPriority();
 
 	// Pre-fill the allocators.
-	allocatorInit();
+	allocatorInit(THREAD_COUNT, NUM_TRANSACTIONS / THREAD_COUNT, TRANSACTION_SIZE);
 
 	// Reserve the transaction vector, for minor performance gains.
 	transactions->reserve(THREAD_COUNT);
@@ -95,6 +85,7 @@ int main(void)
 	std::cout << "\t" << shared.count();
 	std::cout << "\t" << total.count();
 #endif
+	std::cout << "\t" << countConflictFree(transactions);
 	std::cout << "\n";
 
 	// Report on allocator issues.
@@ -10,16 +10,12 @@ void createTransactions()
 	{
 		Operation *ops = new Operation[TRANSACTION_SIZE];
 
-		bool isConflictFree = true;
-
 		bool slow = (rand() % 2 == 0);
 
 		for (size_t k = 0; k < TRANSACTION_SIZE; k++)
 		{
 			if (slow)
 			{
-				isConflictFree = false;
-
 				int r = rand();
 
 				// We'll get the 33-33-33 ratio by checking for mod 3
@@ -46,7 +42,6 @@ void createTransactions()
 				// If even, make a write operation, else make a read operation
 				if (rand() % 2 == 0)
 				{
-					isConflictFree = false;
 					// All operations are writes.
 					ops[k].type = Operation::OpType::write;
 					ops[k].val = rand() % std::numeric_limits<VAL>::max();
@@ -62,7 +57,6 @@ void createTransactions()
 		}
 
 		Desc *desc = new Desc(TRANSACTION_SIZE, ops);
-		desc->isConflictFree = isConflictFree;
 		transactions->push_back(desc);
 	}
 }
@@ -77,7 +71,7 @@ int main(void)
 	setMaxPriority();
 
 	// Pre-fill the allocators.
-	allocatorInit();
+	allocatorInit(THREAD_COUNT, NUM_TRANSACTIONS / THREAD_COUNT, TRANSACTION_SIZE);
 
 	// Reserve the transaction vector, for minor performance gains.
 	transactions->reserve(THREAD_COUNT);
@@ -118,6 +112,7 @@ int main(void)
 	std::cout << "\t" << shared.count();
 	std::cout << "\t" << total.count();
 #endif
+	std::cout << "\t" << countConflictFree(transactions);
 	std::cout << "\n";
 
 	// Report on allocator issues.
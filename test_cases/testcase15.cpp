@@ -10,9 +10,6 @@ void createTransactions()
 	{
 		Operation *ops = new Operation[TRANSACTION_SIZE];
 
-#ifdef CONFLICT_FREE_READS
-		bool isConflictFree = false;
-#endif
 		for (size_t k = 0; k < TRANSACTION_SIZE; k++)
 		{
 			// 33 slow, 66 fast
@@ -73,7 +70,7 @@ int main(void)
 	setMaxPriority();
 
 	// Pre-fill the allocators.
-	allocatorInit();
+	allocatorInit(THREAD_COUNT, NUM_TRANSACTIONS / THREAD_COUNT, TRANSACTION_SIZE);
 
 	// Reserve the transaction vector, for minor performance gains.
 	transactions->reserve(THREAD_COUNT);
@@ -114,6 +111,7 @@ int main(void)
 	std::cout << "\t" << shared.count();
 	std::cout << "\t" << total.count();
 #endif
+	std::cout << "\t" << countConflictFree(transactions);
 	std::cout << "\n";
 
 	// Report on allocator issues.
@@ -41,7 +41,7 @@ int main(void)
 	setMaxPriority();
 
 	// Pre-fill the allocators.
-	allocatorInit();
+	allocatorInit(THREAD_COUNT, NUM_TRANSACTIONS / THREAD_COUNT, TRANSACTION_SIZE);
 
 	// Reserve the transaction vector, for minor performance gains.
 	transactions->reserve(THREAD_COUNT);
@@ -76,7 +76,9 @@ int main(void)
 	std::cout << "Average shared memory time" + std::chrono::duration_cast<std::chrono::TIME_UNIT>(measureSharedTime(transactions)).count();
 	std::cout << "Average transaction time" + std::chrono::duration_cast<std::chrono::TIME_UNIT>(measureTotalTime(transactions)).count();
 #endif
-	std::cout << "\t" << countAborts(transactions) << "\n";
+	std::cout << "\t" << countAborts(transactions);
+	std::cout << "\t" << countConflictFree(transactions);
+	std::cout << "\n";
 
 	// Report on allocator issues.
 	allocatorReport();
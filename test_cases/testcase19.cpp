@@ -18,9 +18,6 @@ void createTransactions()
 		ops[0].index = 1000000;
 
 		Desc *desc = new Desc(1, ops);
-#ifdef CONFLICT_FREE_READS
-		desc->isConflictFree = false;
-#endif
 		transactions->push_back(desc);
 	}
 }
@@ -35,7 +32,7 @@ int main(void)
 	setMaxPriority();
 
 	// Pre-fill the allocators.
-	allocatorInit();
+	allocatorInit(THREAD_COUNT, NUM_TRANSACTIONS / THREAD_COUNT, TRANSACTION_SIZE);
 
 	// Create our threads.
 	std::thread threads[THREAD_COUNT];
@@ -65,6 +62,7 @@ int main(void)
 	std::cout << "\t" << shared.count();
 	std::cout << "\t" << total.count();
 #endif
+	std::cout << "\t" << countConflictFree(transactions);
 	std::cout << "\n";
 
 	// Report on allocator issues.
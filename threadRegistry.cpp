@@ -0,0 +1,61 @@
+#include "threadRegistry.hpp"
+
+std::mutex ThreadRegistry::lock;
+
+std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> ThreadRegistry::freeSlots;
+
+size_t ThreadRegistry::slotCount = 0;
+
+size_t ThreadRegistry::attachedCount = 0;
+
+thread_local size_t ThreadRegistry::threadSlot = ThreadRegistry::NONE;
+
+size_t ThreadRegistry::attach()
+{
+	if (threadSlot != NONE)
+	{
+		return threadSlot;
+	}
+	std::lock_guard<std::mutex> guard(lock);
+	if (freeSlots.empty())
+	{
+		threadSlot = slotCount++;
+	}
+	else
+	{
+		threadSlot = freeSlots.top();
+		freeSlots.pop();
+	}
+	attachedCount++;
+	return threadSlot;
+}
+
+void ThreadRegistry::detach()
+{
+	if (threadSlot == NONE)
+	{
+		return;
+	}
+	std::lock_guard<std::mutex> guard(lock);
+	freeSlots.push(threadSlot);
+	attachedCount--;
+	threadSlot = NONE;
+	return;
+}
+
+size_t ThreadRegistry::slot()
+{
+	return threadSlot;
+}
+
+size_t ThreadRegistry::attached()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return attachedCount;
+}
+
+size_t ThreadRegistry::slots()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return slotCount;
+}
@@ -0,0 +1,51 @@
+/*
+This file holds the registry of threads working on the vectors.
+Threads attach when they start working and detach when they finish, so the number of threads can change at runtime.
+*/
+#ifndef THREADREGISTRY_HPP
+#define THREADREGISTRY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+#include "define.hpp"
+
+// Hands out small, dense slot numbers to attached threads.
+// A detached thread's slot goes to the next thread that attaches, so slot numbers stay below the peak thread count.
+// Any number of threads can attach. THREAD_COUNT is only the number of threads the allocators are sized for.
+class ThreadRegistry
+{
+private:
+	// Guards the slots. Threads only attach and detach when they start and finish, so this is never contended on the hot path.
+	static std::mutex lock;
+	// Slots given up by detached threads. The lowest is reused first.
+	static std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> freeSlots;
+	// The number of slots ever handed out.
+	static size_t slotCount;
+	// The number of threads currently attached.
+	static size_t attachedCount;
+	// The slot of the calling thread.
+	thread_local static size_t threadSlot;
+
+public:
+	// The slot of a thread that is not attached.
+	static const size_t NONE = SIZE_MAX;
+
+	// Attach the calling thread and return its slot.
+	// Attaching an attached thread just returns its slot.
+	static size_t attach();
+	// Give up the calling thread's slot. Does nothing if the thread is not attached.
+	static void detach();
+	// Get the calling thread's slot, or NONE.
+	static size_t slot();
+	// Get the number of threads currently attached.
+	static size_t attached();
+	// Get the number of slots ever handed out, which is the peak number of attached threads.
+	static size_t slots();
+};
+
+#endif
@@ -1,4 +1,10 @@
+#include <thread>
+
+#include "epoch.hpp"
 #include "transVector.hpp"
+#include "transactionPlan.hpp"
+
+BEGIN_ENGINE_NAMESPACE
 
 #ifdef SEGMENTVEC
 
@@ -23,8 +29,6 @@ bool TransactionalVector::prependPage(size_t index, Page<VAL, SGMT_SIZE> *page)
 
 	// Create a bitset to keep track of all locations of interest.
 	std::bitset<Page<VAL, SGMT_SIZE>::SEG_SIZE> targetBits;
-	// Set all bits we want to read or write.
-	targetBits = page->bitset.read | page->bitset.write;
 
 	// The head of the linkedlist of updates.
 	Page<VAL, SGMT_SIZE> *rootPage = NULL;
@@ -33,11 +37,16 @@ bool TransactionalVector::prependPage(size_t index, Page<VAL, SGMT_SIZE> *page)
 	// Keep looping until page insertion suceeds or the transaction fails.
 	while (true)
 	{
+		// Set all bits we want to read or write.
+		// Mins and maxes need no old value, so they never wait on or help the transactions below them.
+		// Reset on every attempt, since pages prepended since the last one may hold newer values for any of them.
+		targetBits = page->bitset.read | page->bitset.write | page->bitset.checkDelta;
+
 		// Get the head of the list of updates for this segment.
 		if (!array->read(index, rootPage))
 		{
 			// Failure means the transaction attempted an invalid read or write, as the vector wasn't allocated to this point.
-			page->transaction->status.store(Desc::TxStatus::aborted);
+			page->transaction->abort(AbortCause::outOfBounds);
 			// DEBUG: Abort reporting.
 			//printf("Aborted!\n");
 			// No need to even try anymore. The whole transaction failed.
@@ -61,6 +70,11 @@ bool TransactionalVector::prependPage(size_t index, Page<VAL, SGMT_SIZE> *page)
 			// Insertion failed, but the transaction is incomplete, so keep trying.
 			return true;
 		}
+		// A page with updates may already be in, with other pages above it.
+		if (page->bitset.delta.any() && page->original()->installed.load())
+		{
+			return true;
+		}
 
 		// Initialize the current page at the start of the linked list of updates.
 		Page<VAL, SGMT_SIZE> *currentPage = rootPage;
@@ -80,25 +94,12 @@ bool TransactionalVector::prependPage(size_t index, Page<VAL, SGMT_SIZE> *page)
 				break;
 			}
 			// Get the set of elements the current page has that we need.
-			std::bitset<SGMT_SIZE> posessedBits = targetBits & (currentPage->bitset.read | currentPage->bitset.write);
+			std::bitset<SGMT_SIZE> posessedBits = targetBits & (currentPage->bitset.read | currentPage->bitset.write | currentPage->bitset.delta);
 			// If this page has said elements.
 			if (!posessedBits.none())
 			{
-				// Check the status of the transaction.
-				typename Desc::TxStatus status = currentPage->transaction->status.load();
-				// If the current page is part of an active transaction.
-				if (status == Desc::TxStatus::active)
-				{
-					// Help the active transaction.
-					while (currentPage->transaction->status.load() == Desc::TxStatus::active)
-					{
-#ifdef HELP
-						completeTransaction(currentPage->transaction, true, index);
-#endif
-					}
-					// Update our status to its final (committed or aborted) state.
-					status = currentPage->transaction->status.load();
-				}
+				// Wait for the page's transaction to reach its final (committed or aborted) state.
+				bool committed = settle(currentPage->transaction, index);
 				// Go through the bits.
 				for (size_t i = 0; i < Page<VAL, SGMT_SIZE>::SEG_SIZE; i++)
 				{
@@ -109,8 +110,16 @@ bool TransactionalVector::prependPage(size_t index, Page<VAL, SGMT_SIZE> *page)
 					}
 					// Used to pass a value around by reference.
 					VAL val = UNSET;
+					// Updates only hold an operand, so merge them into the value below.
+					if (currentPage->bitset.delta[i])
+					{
+						if (!resolveDelta(currentPage, index, i, page->transaction, val))
+						{
+							return true;
+						}
+					}
 					// We only get the new value if it was write committed.
-					if (status == Desc::TxStatus::committed && currentPage->bitset.write[i])
+					else if (committed && currentPage->bitset.write[i])
 					{
 						currentPage->get(i, NEW_VAL, val);
 					}
@@ -129,10 +138,27 @@ bool TransactionalVector::prependPage(size_t index, Page<VAL, SGMT_SIZE> *page)
 						// DEBUG: Abort reporting.
 						//printf("Aborted!\n");
 
-						page->transaction->status.store(Desc::TxStatus::aborted);
+						page->transaction->abort(AbortCause::outOfBounds);
 						// No need to even try anymore. The whole transaction failed.
 						return false;
 					}
+					// Compare writes check the old value now. This decides again on every retry, since the old value may have changed.
+					if (page->bitset.compare[i] && !compareWrite(page, index, i, val))
+					{
+						page->transaction->abort(AbortCause::compareFailed);
+						return false;
+					}
+					// Size still counts the element, so an update may not leave it reading as unset.
+					if (page->bitset.checkDelta[i] && val != UNSET)
+					{
+						VAL operand = UNSET;
+						page->get(i, NEW_VAL, operand);
+						if (Operation::applyDelta(page->deltaType(i), val, operand) == UNSET)
+						{
+							page->transaction->abort(AbortCause::invalid);
+							return false;
+						}
+					}
 				}
 			}
 			// Update our set of target bits.
@@ -144,10 +170,20 @@ bool TransactionalVector::prependPage(size_t index, Page<VAL, SGMT_SIZE> *page)
 
 		// Link our new page to the old root page.
 		page->next = rootPage;
+		// Once our page covers the root, helpers can no longer find it at the top, so mark it as installed first.
+		if (rootPage != NULL && rootPage->bitset.delta.any())
+		{
+			rootPage->original()->installed.store(true);
+		}
 
 		// Insert the page into the desired location.
 		if (array->tryWrite(index, rootPage, page))
 		{
+			// The old root stays in the chain, but is no longer the current version of its segment.
+			if (rootPage != NULL)
+			{
+				Allocator<Page<VAL, SGMT_SIZE>>::retire();
+			}
 			// Finish on success.
 			break;
 		}
@@ -184,6 +220,101 @@ bool TransactionalVector::prependPage(size_t index, Page<VAL, SGMT_SIZE> *page)
 	return true;
 }
 
+bool TransactionalVector::settle(Desc *transaction, size_t index)
+{
+	// Check the status of the transaction.
+	typename Desc::TxStatus status = transaction->status.load();
+	// If the page is part of an active transaction.
+	if (status == Desc::TxStatus::active)
+	{
+		// Help the active transaction.
+		while (transaction->status.load() == Desc::TxStatus::active)
+		{
+#ifdef HELP
+			completeTransaction(transaction, true, index);
+#endif
+		}
+		// Update our status to its final (committed or aborted) state.
+		status = transaction->status.load();
+	}
+	return status == Desc::TxStatus::committed;
+}
+
+bool TransactionalVector::resolveDelta(Page<VAL, SGMT_SIZE> *page, size_t index, size_t offset, Desc *transaction, VAL &val)
+{
+	// The committed updates found so far, newest first.
+	std::vector<Page<VAL, SGMT_SIZE> *> deltas;
+	Page<VAL, SGMT_SIZE> *currentPage = page;
+	while (true)
+	{
+		// If we reach the end, use the generic initializer page instead.
+		if (currentPage == NULL)
+		{
+			currentPage = endPage;
+		}
+		if (currentPage->transaction == transaction)
+		{
+			return false;
+		}
+		if (currentPage->bitset.delta[offset])
+		{
+			// Aborted updates are skipped.
+			if (settle(currentPage->transaction, index))
+			{
+				deltas.push_back(currentPage);
+			}
+		}
+		else if (currentPage->bitset.read[offset] || currentPage->bitset.write[offset])
+		{
+			// Found the value the updates apply to.
+			if (settle(currentPage->transaction, index) && currentPage->bitset.write[offset])
+			{
+				currentPage->get(offset, NEW_VAL, val);
+			}
+			else
+			{
+				currentPage->get(offset, OLD_VAL, val);
+			}
+			break;
+		}
+		currentPage = currentPage->next;
+	}
+	// Apply the updates oldest first. Unset elements stay unset.
+	for (auto i = deltas.rbegin(); i != deltas.rend() && val != UNSET; ++i)
+	{
+		VAL operand = UNSET;
+		(*i)->get(offset, NEW_VAL, operand);
+		val = Operation::applyDelta((*i)->deltaType(offset), val, operand);
+	}
+	return true;
+}
+
+bool TransactionalVector::compareWrite(Page<VAL, SGMT_SIZE> *page, size_t index, size_t offset, VAL oldVal)
+{
+	RWOperation *op = NULL;
+	page->transaction->set.load()->getOp(op, std::make_pair(index, offset));
+	Operation *compare = op->compareOp;
+	if (oldVal == compare->expected)
+	{
+		// Later writes in the transaction already set the new value.
+		if (op->lastWriteOp == compare)
+		{
+			page->set(offset, NEW_VAL, compare->val);
+		}
+		return true;
+	}
+	if (compare->type == Operation::OpType::compareWriteOrAbort)
+	{
+		return false;
+	}
+	// Skip the write by keeping the old value.
+	if (op->lastWriteOp == compare)
+	{
+		page->set(offset, NEW_VAL, oldVal);
+	}
+	return true;
+}
+
 void TransactionalVector::insertPages(std::map<size_t, Page<VAL, SGMT_SIZE> *, ORDER, MemAllocator<std::pair<size_t, Page<VAL, SGMT_SIZE> *>>> *pages, bool helping, size_t startPage)
 {
 	assert(pages != NULL);
@@ -238,7 +369,7 @@ void TransactionalVector::insertPages(std::map<size_t, Page<VAL, SGMT_SIZE> *, O
 	return;
 }
 
-TransactionalVector::TransactionalVector()
+TransactionalVector::TransactionalVector(size_t ring)
 {
 	// Initialize our internal segmented array.
 	array = new SegmentedVector<Page<VAL, SGMT_SIZE> *>();
@@ -270,7 +401,7 @@ TransactionalVector::TransactionalVector()
 	}
 
 	// Initialize the first size page.
-	Page<size_t, 1> *sizePage = new Page<size_t, 1>();
+	Page<size_t, 2> *sizePage = new Page<size_t, 2>();
 	// To ensure we never try to go past the initial size page, claim all values have been set here.
 	sizePage->bitset.read.set();
 	sizePage->bitset.write.set();
@@ -278,9 +409,24 @@ TransactionalVector::TransactionalVector()
 	// There is initially nothing in the vector. Size is 0.
 	sizePage->set(0, NEW_VAL, 0);
 	sizePage->set(0, OLD_VAL, 0);
+	// A deque starts at the beginning of its ring.
+	sizePage->set(1, NEW_VAL, 0);
+	sizePage->set(1, OLD_VAL, 0);
 	// Just point to the generic end transaction to show this operation is committed.
 	sizePage->transaction = endTransaction;
 	size.store(sizePage);
+
+	if (ring != 0)
+	{
+		// Rings are a power of two, so positions wrap with a mask.
+		this->ring = 1;
+		while (this->ring < ring)
+		{
+			this->ring <<= 1;
+		}
+		// Every slot of the ring exists up front, so pushes onto either end never need to grow it.
+		reserve(this->ring);
+	}
 }
 
 bool TransactionalVector::prepareTransaction(Desc *descriptor)
@@ -288,6 +434,11 @@ bool TransactionalVector::prepareTransaction(Desc *descriptor)
 	RWSet *set = descriptor->set.load();
 	if (set == NULL)
 	{
+		// A transaction that finished without a set never gets one, and its operations may already be freed.
+		if (descriptor->status.load() != Desc::TxStatus::active)
+		{
+			return false;
+		}
 		// Initialize the RWSet object.
 		set = Allocator<RWSet>::alloc();
 
@@ -298,7 +449,11 @@ bool TransactionalVector::prepareTransaction(Desc *descriptor)
 		set->createSet(descriptor, this);
 
 		RWSet *nullVal = NULL;
-		descriptor->set.compare_exchange_strong(nullVal, set);
+		if (!descriptor->set.compare_exchange_strong(nullVal, set))
+		{
+			// Another thread published its set first. Nobody else has seen ours.
+			set->retire();
+		}
 	}
 	// Make sure we only work with the set that succeeded first.
 	set = descriptor->set.load();
@@ -306,12 +461,17 @@ bool TransactionalVector::prepareTransaction(Desc *descriptor)
 	// Ensure that we can fit all of the segments we plan to insert.
 	if (!reserve(set->maxReserveAbsolute > set->size ? set->maxReserveAbsolute : set->size))
 	{
-		descriptor->status.store(Desc::TxStatus::aborted);
+		descriptor->abort(AbortCause::outOfBounds);
 		return false;
 	}
 
 	if (descriptor->pages.load() == NULL)
 	{
+		// A transaction that finished without pages never gets any, since its owner may already have retired what it had.
+		if (descriptor->status.load() != Desc::TxStatus::active)
+		{
+			return false;
+		}
 		// Convert the set into pages.
 		set->setToPages(descriptor);
 	}
@@ -319,17 +479,61 @@ bool TransactionalVector::prepareTransaction(Desc *descriptor)
 	return true;
 }
 
-bool TransactionalVector::completeTransaction(Desc *descriptor, bool helping, size_t startPage)
+void TransactionalVector::insertDescriptor(Desc *descriptor, bool helping, size_t startPage)
 {
 	// Insert the pages.
-	insertPages(descriptor->pages.load(), helping, startPage);
+	insertPages(&descriptor->pages.load()->map, helping, startPage);
+	return;
+}
+
+void TransactionalVector::executeGroups(std::vector<Desc *> *groups, bool helping)
+{
+	for (Desc *group : *groups)
+	{
+		if (group->status.load() != Desc::TxStatus::active)
+		{
+			return;
+		}
+		if (!group->vector->prepareTransaction(group))
+		{
+			return;
+		}
+	}
+	groups->front()->vector->completeTransaction(groups->front(), helping);
+	return;
+}
+
+bool TransactionalVector::completeTransaction(Desc *descriptor, bool helping, size_t startPage)
+{
+	insertDescriptor(descriptor, helping, startPage);
+	if (descriptor->groups != NULL)
+	{
+		// A group's pages only go in after every group before it, so only the groups after this one can be missing.
+		for (auto i = std::find(descriptor->groups->begin(), descriptor->groups->end(), descriptor) + 1; i != descriptor->groups->end(); ++i)
+		{
+			(*i)->vector->insertDescriptor(*i, helping, SIZE_MAX);
+		}
+	}
 
 	auto active = Desc::TxStatus::active;
 	auto committed = Desc::TxStatus::committed;
 #ifdef CONFLICT_FREE_READS
 	// Always set the version number before committing.
 	size_t zero = 0;
-	descriptor->version.compare_exchange_strong(zero, globalVersionCounter.fetch_add(1));
+	if (descriptor->groups != NULL)
+	{
+		// Readers of each vector only see its own group, so every group needs one.
+		size_t version = globalVersionCounter.fetch_add(1);
+		for (Desc *group : *descriptor->groups)
+		{
+			zero = 0;
+			group->version.compare_exchange_strong(zero, version);
+		}
+	}
+	else
+	{
+		descriptor->version.compare_exchange_strong(zero, globalVersionCounter.fetch_add(1));
+	}
 #endif
 	// Commit the transaction.
 	// If this fails, either we aborted or some other transaction committed, so no need to retry.
@@ -349,6 +553,24 @@ bool TransactionalVector::completeTransaction(Desc *descriptor, bool helping, si
 }
 
 #ifdef CONFLICT_FREE_READS
+bool TransactionalVector::isReadOnly(Desc *descriptor)
+{
+	// Prepared transactions already know their shape.
+	if (descriptor->plan != NULL)
+	{
+		return descriptor->plan->readOnly;
+	}
+	// Anything that writes, touches size, or reserves must install pages.
+	for (size_t i = 0; i < descriptor->size; i++)
+	{
+		if (descriptor->ops[i].type != Operation::OpType::read)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 void TransactionalVector::executeConflictFreeReads(Desc *descriptor)
 {
 	// Get the time now.
@@ -372,7 +594,7 @@ void TransactionalVector::executeConflictFreeReads(Desc *descriptor)
 		if (!array->read(indexes.first, rootPage))
 		{
 			// Failure means the transaction attempted an invalid read or write, as the vector wasn't allocated to this point.
-			descriptor->status.store(Desc::TxStatus::aborted);
+			descriptor->abort(AbortCause::outOfBounds);
 			// DEBUG: Abort reporting.
 			//printf("Aborted!\n");
 
@@ -382,6 +604,8 @@ void TransactionalVector::executeConflictFreeReads(Desc *descriptor)
 
 		// Initialize the current page at the start of the linked list of updates.
 		Page<VAL, SGMT_SIZE> *currentPage = rootPage;
+		// Committed updates above the value found, newest first.
+		std::vector<Page<VAL, SGMT_SIZE> *> deltas;
 		bool traverse = true;
 		while (traverse)
 		{
@@ -400,8 +624,8 @@ void TransactionalVector::executeConflictFreeReads(Desc *descriptor)
 				continue;
 			}
 
-			// If this page did not read or write to this location.
-			if ((currentPage->bitset.read[indexes.second] || currentPage->bitset.write[indexes.second]) == 0)
+			// If this page did not read, write, or update this location.
+			if ((currentPage->bitset.read[indexes.second] || currentPage->bitset.write[indexes.second] || currentPage->bitset.delta[indexes.second]) == 0)
 			{
 				// Go to the next page.
 				currentPage = currentPage->next;
@@ -419,6 +643,22 @@ void TransactionalVector::executeConflictFreeReads(Desc *descriptor)
 				continue;
 			}
 
+			// Updates are merged into the value below them, so keep looking.
+			if (currentPage->bitset.delta[indexes.second])
+			{
+				Desc::TxStatus status = currentPage->transaction->status.load();
+				if (status == Desc::TxStatus::active)
+				{
+					ignoredTransactions.insert(currentPage->transaction);
+				}
+				else if (status == Desc::TxStatus::committed)
+				{
+					deltas.push_back(currentPage);
+				}
+				currentPage = currentPage->next;
+				continue;
+			}
+
 			// The element's logical status is based on the page's transaction status.
 			switch (currentPage->transaction->status.load())
 			{
@@ -451,11 +691,18 @@ void TransactionalVector::executeConflictFreeReads(Desc *descriptor)
 			// Go to the next page.
 			currentPage = currentPage->next;
 		}
+		// Apply the updates oldest first.
+		for (auto j = deltas.rbegin(); j != deltas.rend() && descriptor->ops[i].ret != UNSET; ++j)
+		{
+			VAL operand = UNSET;
+			(*j)->get(indexes.second, NEW_VAL, operand);
+			descriptor->ops[i].ret = Operation::applyDelta((*j)->deltaType(indexes.second), descriptor->ops[i].ret, operand);
+		}
 
 		// Abort if an UNSET is read.
 		if (descriptor->ops[i].ret == UNSET)
 		{
-			descriptor->status.store(Desc::TxStatus::aborted);
+			descriptor->abort(AbortCause::outOfBounds);
 			return;
 		}
 	}
@@ -467,8 +714,118 @@ void TransactionalVector::executeConflictFreeReads(Desc *descriptor)
 
 void TransactionalVector::executeTransaction(Desc *descriptor)
 {
+	{
+		// Any thread running a transaction may help another one, so every thread does so inside a guard.
+		EpochGuard guard;
+		submitTransaction(descriptor);
+	}
+	descriptor->retireSets();
+	return;
+}
+
+void TransactionalVector::submitTransaction(Desc *descriptor)
+{
+	// A log can't take part in a transaction spanning several vectors, since its appends aren't ordered with anything else.
+	if (descriptor->groups != NULL)
+	{
+		for (Desc *group : *descriptor->groups)
+		{
+			if (group->vector->log != NULL)
+			{
+				descriptor->abort(AbortCause::invalid);
+				return;
+			}
+		}
+	}
+	// Appends never conflict, so they skip announcing and helping.
+	if (log != NULL)
+	{
+		log->append(descriptor);
+		return;
+	}
+#ifdef WAIT_FREE
+#ifdef CONFLICT_FREE_READS
+	// Conflict-free reads never wait on anyone, and must not get pages installed by helpers, so they aren't announced.
+	if (descriptor->groups == NULL && ring == 0 && isReadOnly(descriptor))
+	{
+		runTransaction(descriptor);
+		return;
+	}
+#endif
+	size_t slot = announcements.announce(descriptor);
+	// Finish every transaction announced before this one, oldest first.
+	for (Desc *older = announcements.oldest(descriptor->ticket.load()); older != NULL; older = announcements.oldest(descriptor->ticket.load()))
+	{
+		sizeHelp(older);
+	}
+	runTransaction(descriptor);
+	announcements.withdraw(slot);
+#else
+	runTransaction(descriptor);
+#endif
+	return;
+}
+
+void TransactionalVector::makeLog()
+{
+	log = new AppendLog();
+	return;
+}
+
+bool TransactionalVector::bulkLoad(const VAL *values, size_t count, unsigned int threads)
+{
+	Page<size_t, 2> *sizePage = size.load();
+	size_t current = 0;
+	sizePage->get(0, sizePage->transaction->status.load() == Desc::TxStatus::committed ? NEW_VAL : OLD_VAL, current);
+	if (log != NULL || current != 0 || (ring != 0 && count > ring) || !reserve(count))
+	{
+		return false;
+	}
+	const size_t segSize = Page<VAL, SGMT_SIZE>::SEG_SIZE;
+	// Each thread gets whole pages, so no page is built by two of them.
+	parallelFor(count, segSize, threads, [&](size_t begin, size_t end) {
+		size_t firstPage = begin / segSize;
+		size_t pageCount = (end - begin + segSize - 1) / segSize;
+		// Allocate the thread's pages in one block. Like all pages, they are never freed.
+		Page<VAL, SGMT_SIZE> *pages = new Page<VAL, SGMT_SIZE>[pageCount];
+		for (size_t p = 0; p < pageCount; p++)
+		{
+			Page<VAL, SGMT_SIZE> *page = &pages[p];
+			size_t start = (firstPage + p) * segSize;
+			size_t filled = std::min(segSize, count - start);
+			// Base pages are written by the generic committed transaction, so reads take their new values.
+			// Positions past the last value are left out, and resolve to the end page.
+			page->transaction = endTransaction;
+			for (size_t i = 0; i < filled; i++)
+			{
+				page->bitset.write.set(i);
+				page->set(i, NEW_VAL, values[start + i]);
+			}
+			array->write(firstPage + p, page);
+		}
+	});
+	sizePage->set(0, NEW_VAL, count);
+	sizePage->set(0, OLD_VAL, count);
+	// The values start at the front of a deque's ring.
+	sizePage->set(1, NEW_VAL, 0);
+	sizePage->set(1, OLD_VAL, 0);
+	return true;
+}
+
+void TransactionalVector::runTransaction(Desc *descriptor)
+{
+	// Transactions spanning several vectors run each group on its own vector.
+	// They never take the conflict-free path, since reads of separate vectors would not be ordered together.
+	if (descriptor->groups != NULL)
+	{
+		executeGroups(descriptor->groups, false);
+		return;
+	}
 #ifdef CONFLICT_FREE_READS
 	// Determine if this is a help-free read transaction.
+	// Read-only transactions never need to install pages, which would only force writers to help them.
+	// Deque indexes depend on the head, which only the size page holds, so reads of a deque take the general path.
+	descriptor->isConflictFree = ring == 0 && isReadOnly(descriptor);
 	if (descriptor->isConflictFree)
 	{
 #ifdef METRICS
@@ -489,12 +846,15 @@ void TransactionalVector::executeTransaction(Desc *descriptor)
 	descriptor->startTime = std::chrono::high_resolution_clock::now();
 #endif
 	// Initialize the set for the descriptor.
-	prepareTransaction(descriptor);
+	bool prepared = prepareTransaction(descriptor);
 #ifdef METRICS
 	descriptor->preprocessTime = std::chrono::high_resolution_clock::now();
 #endif
-	// If the transaction committed.
-	completeTransaction(descriptor);
+	// A transaction that failed to prepare already aborted, and has nothing to insert.
+	if (prepared)
+	{
+		completeTransaction(descriptor);
+	}
 #ifdef METRICS
 	descriptor->endTime = std::chrono::high_resolution_clock::now();
 #endif
@@ -502,8 +862,17 @@ void TransactionalVector::executeTransaction(Desc *descriptor)
 
 void TransactionalVector::sizeHelp(Desc *descriptor)
 {
+	// Groups are prepared one after another, so the groups after this one may not be ready yet.
+	if (descriptor->groups != NULL)
+	{
+		executeGroups(descriptor->groups, true);
+		return;
+	}
 	// Must actually start at the very beginning.
-	prepareTransaction(descriptor);
+	if (!prepareTransaction(descriptor))
+	{
+		return;
+	}
 	// Must help from the beginning of the list, since we didn't help part way through.
 	completeTransaction(descriptor, true);
 }
@@ -537,7 +906,7 @@ void TransactionalVector::printContents()
 				currentPage = endPage;
 			}
 			// Get the set of elements the current page has that we need.
-			std::bitset<SGMT_SIZE> posessedBits = targetBits & (currentPage->bitset.read | currentPage->bitset.write);
+			std::bitset<SGMT_SIZE> posessedBits = targetBits & (currentPage->bitset.read | currentPage->bitset.write | currentPage->bitset.delta);
 			// If this page has said elements.
 			if (!posessedBits.none())
 			{
@@ -556,7 +925,17 @@ void TransactionalVector::printContents()
 				for (size_t j = 0; j < SGMT_SIZE; j++)
 				{
 					// We only care about the possessed bits.
-					if (posessedBits[j])
+					if (!posessedBits[j])
+					{
+						continue;
+					}
+					// Show updates merged with the values below them.
+					if (currentPage->bitset.delta[j])
+					{
+						resolveDelta(currentPage, i, j, NULL, newElements[j]);
+						oldElements[j] = newElements[j];
+					}
+					else
 					{
 						currentPage->get(j, OLD_VAL, oldElements[j]);
 						currentPage->get(j, NEW_VAL, newElements[j]);
@@ -580,4 +959,113 @@ void TransactionalVector::printContents()
 	return;
 }
 
-#endif
\ No newline at end of file
+#ifdef CONFLICT_FREE_READS
+void TransactionalVector::resolvePage(size_t index, size_t version, VAL *values)
+{
+	Page<VAL, SGMT_SIZE> *currentPage = NULL;
+	// Pages past the end of the array have never been written.
+	if (!array->read(index, currentPage))
+	{
+		currentPage = endPage;
+	}
+	std::bitset<SGMT_SIZE> targetBits;
+	targetBits.set();
+	// The committed updates found above the values they apply to, newest first, with the elements each applies to.
+	std::vector<std::pair<Page<VAL, SGMT_SIZE> *, std::bitset<SGMT_SIZE>>> deltas;
+	while (!targetBits.none())
+	{
+		// If we reach the end before identifying all values, use a generic initializer page instead.
+		if (currentPage == NULL)
+		{
+			currentPage = endPage;
+		}
+		// Get the set of elements the current page has that we need.
+		std::bitset<SGMT_SIZE> posessedBits = targetBits & (currentPage->bitset.read | currentPage->bitset.write | currentPage->bitset.delta);
+		if (!posessedBits.none())
+		{
+			Desc *transaction = currentPage->transaction;
+			// A transaction still running may yet commit with an older version, so wait for it to finish.
+			while (transaction->status.load() == Desc::TxStatus::active)
+			{
+				std::this_thread::yield();
+			}
+			// Aborted pages changed nothing, and later ones committed after the snapshot, so the values are further down.
+			// The old values of an aborted page can come from a later transaction, so they can't be used either.
+			if (transaction->status.load() == Desc::TxStatus::committed && transaction->version.load() <= version)
+			{
+				std::bitset<SGMT_SIZE> deltaBits = posessedBits & currentPage->bitset.delta;
+				if (!deltaBits.none())
+				{
+					deltas.push_back(std::make_pair(currentPage, deltaBits));
+					posessedBits &= ~deltaBits;
+				}
+				for (size_t i = 0; i < SGMT_SIZE; i++)
+				{
+					if (posessedBits[i])
+					{
+						currentPage->get(i, currentPage->bitset.write[i] ? NEW_VAL : OLD_VAL, values[i]);
+					}
+				}
+				// Updates only hold an operand, so keep looking for the value below them.
+				targetBits &= ~posessedBits;
+			}
+		}
+		currentPage = currentPage->next;
+	}
+	// Apply the updates oldest first. Unset elements stay unset.
+	for (auto i = deltas.rbegin(); i != deltas.rend(); ++i)
+	{
+		for (size_t j = 0; j < SGMT_SIZE; j++)
+		{
+			if (i->second[j] && values[j] != UNSET)
+			{
+				VAL operand = UNSET;
+				i->first->get(j, NEW_VAL, operand);
+				values[j] = Operation::applyDelta(i->first->deltaType(j), values[j], operand);
+			}
+		}
+	}
+	return;
+}
+
+TransactionalVector::Snapshot TransactionalVector::snapshot()
+{
+	Snapshot snapshot;
+	// Transactions take their versions from the same counter as they commit.
+	snapshot.version = globalVersionCounter.fetch_add(1);
+	snapshot.size = 0;
+	snapshot.head = 0;
+	// Find size as of the snapshot, the same way as an element.
+	// Size pages hold both values for read and write, so the first that counts has them.
+	for (Page<size_t, 2> *sizePage = size.load(); sizePage != NULL; sizePage = sizePage->next)
+	{
+		Desc *transaction = sizePage->transaction;
+		while (transaction->status.load() == Desc::TxStatus::active)
+		{
+			std::this_thread::yield();
+		}
+		if (transaction->status.load() == Desc::TxStatus::committed && transaction->version.load() <= snapshot.version)
+		{
+			sizePage->get(0, NEW_VAL, snapshot.size);
+			sizePage->get(1, NEW_VAL, snapshot.head);
+			break;
+		}
+	}
+	return snapshot;
+}
+
+uint64_t TransactionalVector::parallelReduce(const Snapshot &snapshot, Reduction reduction, unsigned int threads)
+{
+	auto fold = [reduction](uint64_t partial, const VAL *values, size_t count) {
+		return reduceValues(reduction, partial, values, count);
+	};
+	auto combine = [reduction](uint64_t a, uint64_t b) {
+		return combineReductions(reduction, a, b);
+	};
+	return parallelReduce(snapshot, reductionIdentity(reduction), fold, combine, threads);
+}
+#endif
+
+#endif
+
+END_ENGINE_NAMESPACE
\ No newline at end of file
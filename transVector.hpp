@@ -1,20 +1,28 @@
 #ifndef TRANSVECTOR_HPP
 #define TRANSVECTOR_HPP
 
+#include <algorithm>
 #include <assert.h>
 #include <atomic>
 #include <cstddef>
 #include <map>
+#include <mutex>
 #include <ostream>
 #include <set>
+#include <vector>
 
 #include "allocator.hpp"
+#include "announcements.hpp"
+#include "appendLog.hpp"
 #include "define.hpp"
 #include "deltaPage.hpp"
+#include "parallelFor.hpp"
 #include "rwSet.hpp"
 #include "segmentedVector.hpp"
 #include "transaction.hpp"
 
+BEGIN_ENGINE_NAMESPACE
+
 #ifdef SEGMENTVEC
 
 class RWOperation;
@@ -35,31 +43,77 @@ private:
 	Page<VAL, SGMT_SIZE> *endPage = NULL;
 	// A generic committed transaction.
 	Desc *endTransaction = NULL;
+#ifdef WAIT_FREE
+	// The transactions each thread is running on this vector.
+	Announcements announcements;
+#endif
 
 	bool reserve(size_t size);
 
 	// Prepends a delta update on an existing page.
 	// Only sets oldVal values and the next pointer here.
 	bool prependPage(size_t index, Page<VAL, SGMT_SIZE> *page);
+	// Check a compare write against the old value found for its element, and set the page's new value to match.
+	// Returns false if the transaction must abort.
+	bool compareWrite(Page<VAL, SGMT_SIZE> *page, size_t index, size_t offset, VAL oldVal);
+	// Wait for a transaction found on a page to finish, helping it along.
+	// Returns true if it committed.
+	bool settle(Desc *transaction, size_t index);
+	// Find the value of an element updated on a page, by merging the committed updates from that page down to the last value written.
+	// Returns false if the search reaches a page of the given transaction, as that means another thread already inserted it.
+	bool resolveDelta(Page<VAL, SGMT_SIZE> *page, size_t index, size_t offset, Desc *transaction, VAL &val);
 
 	// Takes in a set of pages and inserts them into our vector.
 	// startPage is used in the helping scheme to start inserting at a specific page.
 	void insertPages(std::map<size_t, Page<VAL, SGMT_SIZE> *, ORDER, MemAllocator<std::pair<size_t, Page<VAL, SGMT_SIZE> *>>> *pages, bool helping = false, size_t startPage = SIZE_MAX);
 
+	// Insert the pages of one descriptor.
+	void insertDescriptor(Desc *descriptor, bool helping, size_t startPage);
+	// Prepare every group of a transaction spanning several vectors, then insert all of them and commit.
+	// Pages only go in once every group is prepared, so anyone who finds one can finish the whole transaction.
+	static void executeGroups(std::vector<Desc *> *groups, bool helping);
+
 	// A special case where conflict-free reads occur.
 	void executeConflictFreeReads(Desc *descriptor);
+#ifdef CONFLICT_FREE_READS
+	// Find every value of a page as of a version, by ignoring the pages of later and aborted transactions.
+	// Waits for transactions still running on the page, without helping, so it needs no allocators.
+	// Elements without a value come out UNSET.
+	void resolvePage(size_t index, size_t version, VAL *values);
+#endif
+	// Check if a transaction only reads, so it can take the conflict-free path.
+	static bool isReadOnly(Desc *descriptor);
+	// Run a transaction, without announcing it first.
+	void runTransaction(Desc *descriptor);
+	// Hand a transaction to the log, or announce it if need be and run it.
+	// Called inside an epoch guard.
+	void submitTransaction(Desc *descriptor);
 
 public:
-	// A page holding our shared size variable.
+	// A page holding our shared size variable, and the head of a deque.
 	// Access is public because the RWSet must be able to change it.
-	std::atomic<Page<size_t, 1> *> size;
-	// Default contructor.
-	TransactionalVector();
+	std::atomic<Page<size_t, 2> *> size;
+	// The number of elements a deque can hold, or 0 for a plain vector.
+	size_t ring = 0;
+	// Build a vector.
+	// ring:    Makes the vector a deque that can hold this many elements, rounded up to a power of two. 0 for a plain vector.
+	explicit TransactionalVector(size_t ring = 0);
+	// The log push-only transactions append to in log mode, or NULL for a plain vector.
+	AppendLog *log = NULL;
+	// Switch to log mode, where the vector only takes push-only transactions.
+	// Only call before any transaction runs.
+	void makeLog();
+	// Fill an empty vector without running transactions, writing base pages straight into the array.
+	// Only valid before any transaction runs, and before any other thread has the vector.
+	// threads: The number of threads that build pages, each for its own range of them.
+	// Returns false if the vector isn't empty, or the values don't fit.
+	bool bulkLoad(const VAL *values, size_t count, unsigned int threads);
 	// Create a RWSet for the transaction.
 	// If helping, this will only be called on a size conflict.
 	bool prepareTransaction(Desc *descriptor);
 	// Finish the vector transaction.
 	// Used for helping.
+	// A group of a transaction spanning several vectors also inserts the groups after it, on their own vectors.
 	bool completeTransaction(Desc *descriptor, bool helping = false, size_t startPage = SIZE_MAX);
 	// Apply a transaction to a vector.
 	void executeTransaction(Desc *descriptor);
@@ -67,8 +121,112 @@ public:
 	void sizeHelp(Desc *descriptor);
 	// Print out the values stored in the vector.
 	void printContents();
+#ifdef CONFLICT_FREE_READS
+	// A version-consistent view of the vector, for scans that run outside of transactions.
+	// It sees every transaction that committed before it was taken, and none that committed after.
+	// Pages are never freed, so a snapshot stays valid as long as the vector.
+	struct Snapshot
+	{
+		size_t version;
+		size_t size;
+		size_t head;
+	};
+	// Take a snapshot. Only waits for transactions already committing on size, and never blocks new ones.
+	Snapshot snapshot();
+	// Call body(first, values, count) on every element of a snapshot, in runs of consecutive indexes starting at first.
+	// Each thread resolves its own range of pages and passes them on, so body runs in parallel and in no particular order.
+	template <class Body>
+	void parallelForEach(const Snapshot &snapshot, Body body, unsigned int threads = THREAD_COUNT);
+	// Reduce the elements of a snapshot, each thread folding its range of pages into its own partial.
+	// fold:    Folds a run of values into a partial, as fold(partial, values, count).
+	// combine: Merges the partials of two threads.
+	template <class T, class Fold, class Combine>
+	T parallelReduce(const Snapshot &snapshot, T identity, Fold fold, Combine combine, unsigned int threads = THREAD_COUNT);
+	// Run one of the built-in reductions over a snapshot.
+	uint64_t parallelReduce(const Snapshot &snapshot, Reduction reduction, unsigned int threads = THREAD_COUNT);
+
+private:
+	// Pass the elements of a snapshot on the pages in [begin, end) to body, in runs of consecutive indexes.
+	// begin and end are element positions, on page boundaries.
+	template <class Body>
+	void scanPages(const Snapshot &snapshot, size_t begin, size_t end, Body &body);
+	// The number of element positions a snapshot's pages cover.
+	size_t span(const Snapshot &snapshot)
+	{
+		// A deque's elements can sit anywhere on its ring.
+		return ring == 0 ? snapshot.size : ring;
+	}
+#endif
 };
 
+#ifdef CONFLICT_FREE_READS
+template <class Body>
+void TransactionalVector::scanPages(const Snapshot &snapshot, size_t begin, size_t end, Body &body)
+{
+	// Page is still incomplete here, but its SEG_SIZE is always SGMT_SIZE.
+	const size_t segSize = SGMT_SIZE;
+	VAL values[SGMT_SIZE];
+	for (size_t start = begin; start < end; start += segSize)
+	{
+		resolvePage(start / segSize, snapshot.version, values);
+		if (ring == 0)
+		{
+			body(start, (const VAL *)values, std::min(segSize, snapshot.size - start));
+			continue;
+		}
+		// A deque's elements wrap around its ring, so split the page into runs of consecutive indexes.
+		// A run ends past the last element, and where the ring wraps back to index 0.
+		size_t first = segSize;
+		for (size_t i = 0; i < segSize; i++)
+		{
+			size_t logical = (start + i - snapshot.head) & (ring - 1);
+			bool inside = start + i < ring && logical < snapshot.size;
+			if (first != segSize && (!inside || logical == 0))
+			{
+				body((start + first - snapshot.head) & (ring - 1), (const VAL *)values + first, i - first);
+				first = segSize;
+			}
+			if (inside && first == segSize)
+			{
+				first = i;
+			}
+		}
+		if (first != segSize)
+		{
+			body((start + first - snapshot.head) & (ring - 1), (const VAL *)values + first, segSize - first);
+		}
+	}
+	return;
+}
+
+template <class Body>
+void TransactionalVector::parallelForEach(const Snapshot &snapshot, Body body, unsigned int threads)
+{
+	parallelFor(span(snapshot), SGMT_SIZE, threads, [&](size_t begin, size_t end) {
+		scanPages(snapshot, begin, end, body);
+	});
+	return;
+}
+
+template <class T, class Fold, class Combine>
+T TransactionalVector::parallelReduce(const Snapshot &snapshot, T identity, Fold fold, Combine combine, unsigned int threads)
+{
+	T result = identity;
+	std::mutex resultLock;
+	parallelFor(span(snapshot), SGMT_SIZE, threads, [&](size_t begin, size_t end) {
+		T partial = identity;
+		auto foldRun = [&](size_t, const VAL *values, size_t count) {
+			partial = fold(partial, values, count);
+		};
+		scanPages(snapshot, begin, end, foldRun);
+		// Threads only meet once, to merge their partials.
+		std::lock_guard<std::mutex> guard(resultLock);
+		result = combine(result, partial);
+	});
+	return result;
+}
+#endif
+
 // Only needed if running C++ 2011 or older.
 // Should not use on C++ 2014 or later, since it will conflict with a built-in function.
 #if __cplusplus < 201402L
@@ -81,4 +239,6 @@ constexpr std::reverse_iterator<Iter> make_reverse_iterator(Iter i)
 
 #endif
 
+END_ENGINE_NAMESPACE
+
 #endif
\ No newline at end of file
@@ -1,6 +1,38 @@
+#include <algorithm>
+
+#include "epoch.hpp"
 #include "transaction.hpp"
+#include "transactionPlan.hpp"
+#if defined(SEGMENTVEC) || defined(COMPACTVEC)
+#include "rwSet.hpp"
+#endif
+
+BEGIN_ENGINE_NAMESPACE
+
+#if defined(SEGMENTVEC) || defined(COMPACTVEC)
+// Recycle a set once no helper can reach it.
+static void reclaimSet(void *set)
+{
+	((RWSet *)set)->retire();
+	return;
+}
+#endif
+
+#ifdef SEGMENTVEC
+// Recycle a pages map once no helper can reach it. The pages themselves stay in the vector.
+static void reclaimPages(void *pages)
+{
+	Allocator<PageMap>::dealloc((PageMap *)pages);
+	return;
+}
+#endif
 
 Desc::Desc(unsigned int size, Operation *ops)
+#ifndef BOOSTEDVEC
+	: status(ownStatus), abortCause(ownCause)
+#else
+	: abortCause(ownCause)
+#endif
 {
 	this->size = size;
 	this->ops = ops;
@@ -15,6 +47,11 @@ Desc::Desc(unsigned int size, Operation *ops)
 	set.store(NULL);
 #else
 	set = NULL;
+#endif
+	abortCause.store(AbortCause::none);
+#ifdef WAIT_FREE
+	// Only announced transactions get a ticket.
+	ticket.store(0);
 #endif
 #ifdef CONFLICT_FREE_READS
 	// Initialize the time to the lowest possbile value.
@@ -24,12 +61,139 @@ Desc::Desc(unsigned int size, Operation *ops)
 	return;
 }
 
+Desc::Desc(const TransactionPlan &plan, Operation *ops) : Desc(plan.types.size(), ops)
+{
+	this->plan = &plan;
+	plan.bind(ops);
+	return;
+}
+
+#if defined(SEGMENTVEC) || defined(COMPACTVEC) || defined(BOOSTEDVEC)
+Desc::Desc(const std::vector<OpGroup> &groups) : Desc(0, NULL)
+{
+	this->groups = new std::vector<Desc *>();
+	for (const OpGroup &group : groups)
+	{
+		this->groups->push_back(new Desc(this, group));
+	}
+	// Every transaction updates vectors in the same order, so helping one never leads back to another that helped it.
+	std::sort(this->groups->begin(), this->groups->end(), [](Desc *a, Desc *b) { return a->vector < b->vector; });
+	// Two groups on one vector would run as two transactions on it, each waiting on the other, so the transaction never runs.
+	for (size_t i = 1; i < this->groups->size(); i++)
+	{
+		if ((*this->groups)[i - 1]->vector == (*this->groups)[i]->vector)
+		{
+			abort(AbortCause::invalid);
+			break;
+		}
+	}
+	return;
+}
+
+Desc::Desc(Desc *owner, const OpGroup &group)
+#ifndef BOOSTEDVEC
+	: status(owner->status), abortCause(owner->abortCause)
+#else
+	: abortCause(owner->abortCause)
+#endif
+{
+	this->size = group.size;
+	this->ops = group.ops;
+	this->groups = owner->groups;
+	this->vector = group.vector;
+#ifdef SEGMENTVEC
+	pages.store(NULL);
+#endif
+#ifndef BOOSTEDVEC
+	set.store(NULL);
+#else
+	set = NULL;
+#endif
+#ifdef WAIT_FREE
+	ticket.store(0);
+#endif
+#ifdef CONFLICT_FREE_READS
+	version.store(0);
+#endif
+	return;
+}
+#endif
+
 Desc::~Desc()
 {
 	//delete ops;
+#if defined(SEGMENTVEC) || defined(COMPACTVEC) || defined(BOOSTEDVEC)
+	// Only the whole transaction owns its groups.
+	if (groups != NULL && vector == NULL)
+	{
+		for (Desc *group : *groups)
+		{
+			delete group;
+		}
+		delete groups;
+	}
+#endif
+	return;
+}
+
+#if defined(SEGMENTVEC) || defined(COMPACTVEC)
+void Desc::retireSets()
+{
+	// Each group of a transaction spanning several vectors has a set and pages of its own.
+	if (groups != NULL && vector == NULL)
+	{
+		for (Desc *group : *groups)
+		{
+			group->retireSets();
+		}
+		return;
+	}
+	if (set.load() != NULL)
+	{
+		Epoch::retire(set.load(), reclaimSet);
+	}
+#ifdef SEGMENTVEC
+	if (pages.load() != NULL)
+	{
+		Epoch::retire(pages.load(), reclaimPages);
+	}
+#endif
+	return;
+}
+#endif
+
+void Desc::abort(AbortCause cause)
+{
+	AbortCause none = AbortCause::none;
+	abortCause.compare_exchange_strong(none, cause);
+#ifndef BOOSTEDVEC
+	// A helper working from a stale view may abort after the transaction committed, so only an active one aborts.
+	// The cause is then ignored, since it is only read once a transaction has aborted.
+	TxStatus expected = active;
+	status.compare_exchange_strong(expected, aborted);
+#endif
 	return;
 }
 
+#if defined(BOOSTEDVEC) || defined(STMVEC) || defined(COARSEVEC) || defined(STOVEC)
+void Desc::reset()
+{
+#ifndef BOOSTEDVEC
+	status.store(active);
+	set.store(NULL);
+#else
+	// The boosted vector already released the locks and the set before returning.
+	set = NULL;
+	locks.clear();
+#endif
+	abortCause.store(AbortCause::none);
+#ifdef CONFLICT_FREE_READS
+	version.store(0);
+#endif
+	return;
+}
+#endif
+
 VAL *Desc::getResult(size_t index)
 {
 	// If we request a result at an invalid operation index.
@@ -76,33 +240,4 @@ void Desc::print()
 }
 #endif
 
-void Operation::print()
-{
-	const char *typeStrList[] = {"pushBack", "popBack", "reserve", "read", "write", "size"};
-	size_t typeStrIndex = 0;
-	switch (type)
-	{
-	case pushBack:
-		typeStrIndex = 0;
-		break;
-	case popBack:
-		typeStrIndex = 1;
-		break;
-	case reserve:
-		typeStrIndex = 2;
-		break;
-	case read:
-		typeStrIndex = 3;
-		break;
-	case write:
-		typeStrIndex = 4;
-		break;
-	case size:
-		typeStrIndex = 5;
-		break;
-	}
-	std::cout << "Type:\t" << typeStrList[typeStrIndex] << std::endl;
-	std::cout << "index:\t" << index << std::endl;
-	std::cout << "val:\t" << val << std::endl;
-	std::cout << "ret:\t" << ret << std::endl;
-}
+END_ENGINE_NAMESPACE
@@ -12,10 +12,17 @@ The actual vector will pre-process each of these transactions into a simpler rea
 #include <map>
 #include <ostream>
 #include <string>
+#include <vector>
 
 #include "define.hpp"
 #include "deltaPage.hpp"
 #include "memAllocator.hpp"
+#include "operation.hpp"
+#include "retryPolicy.hpp"
+
+class TransactionPlan;
+
+BEGIN_ENGINE_NAMESPACE
 
 template <class T, size_t S>
 class Page;
@@ -25,55 +32,48 @@ class RWSet;
 class BoostedElement;
 #endif
 
-#ifdef CONFLICT_FREE_READS
-// The global version counter.
-// Used for conflict-free reads.
-static std::atomic<size_t> globalVersionCounter(1);
+#ifdef SEGMENTVEC
+class TransactionalVector;
+typedef TransactionalVector GroupVector;
+#endif
+#ifdef COMPACTVEC
+class CompactVector;
+typedef CompactVector GroupVector;
+#endif
+#ifdef BOOSTEDVEC
+class BoostedVector;
+typedef BoostedVector GroupVector;
 #endif
 
-// A standard, user-generated operation.
-// Works with values of type T.
-struct Operation
+#if defined(SEGMENTVEC) || defined(COMPACTVEC) || defined(BOOSTEDVEC)
+// The operations a transaction spanning several vectors runs on one of them.
+struct OpGroup
 {
-	// A high-level operation supported within a transaction.
-	enum OpType
-	{
-		// Write to a position relative to the current size.
-		// Ignores bounds checking, since size reading must be part of the transaction.
-		pushBack,
-		// Read from a position relative to the current size.
-		// Ignores bounds checking, since size reading must be part of the transaction.
-		popBack,
-		// Ensure enough space has been allocated.
-		reserve,
-		// Read at an absolute position in the vector.
-		// Can fail bounds checking.
-		read,
-		// Write at an absolute position in the vector.
-		// Can fail bounds checking.
-		write,
-		// Simillar to read, but always at the size index (probably 1?).
-		// Returned answer can be offset by a transaction's push and pop ops.
-		size,
-	};
-
-	// The type of operation being performed.
-	OpType type;
-	// The index being affected by the operation.
-	// Only used for read and write.
-	// Also used as the value for size, mostly because it's a convienient and otherwise unused integer.
-	size_t index;
-	// The value being written.
-	// Used for push and write.
-	// Pop implicitly writes an unset value for bounds checking.
-	VAL val;
-	// The return value for this operation.
-	// Only used for read, pop, and size.
-	// Only safe to read if the transaction has committed.
-	VAL ret;
+	// The vector to run the operations on.
+	GroupVector *vector;
+	// The number of operations in the group.
+	unsigned int size;
+	// An array of the operations themselves.
+	Operation *ops;
+};
+#endif
 
-	void print();
+#ifdef SEGMENTVEC
+// The pages a transaction inserts, ordered from low to high.
+// Helpers may each build one at once, so every map keeps its nodes in a region of its own, released with it.
+struct PageMap
+{
+	// Declared first, so it outlives the map when both are destroyed.
+	Region region;
+	std::map<size_t, Page<VAL, SGMT_SIZE> *, ORDER, MemAllocator<std::pair<size_t, Page<VAL, SGMT_SIZE> *>>> map;
 };
+#endif
+
+#ifdef CONFLICT_FREE_READS
+// The global version counter.
+// Used for conflict-free reads.
+static std::atomic<size_t> globalVersionCounter(1);
+#endif
 
 // This is the descriptor generated by the programmer.
 // This will be converted into an internal transaction to run on the shared datastructure.
@@ -89,25 +89,42 @@ struct Desc
 	};
 
 	// The status of the transaction.
-	std::atomic<TxStatus> status;
+	// Every group of a transaction spanning several vectors refers to the status of the whole transaction, so a single CAS commits them all.
+	std::atomic<TxStatus> &status;
 	std::atomic<RWSet *> set;
 #else
 	RWSet *set;
 	// A list of locks aquired that must be released when the transaction finishes.
 	std::vector<BoostedElement *> locks;
 #endif
+	// Why the transaction aborted. Groups of a transaction spanning several vectors share it, same as the status.
+	std::atomic<AbortCause> &abortCause;
 	// The number of operations in the transaction.
 	unsigned int size = 0;
 	// An array of the operations themselves.
 	Operation *ops;
+	// The plan the operations were bound from, if any.
+	const TransactionPlan *plan = NULL;
+#if defined(SEGMENTVEC) || defined(COMPACTVEC) || defined(BOOSTEDVEC)
+	// The descriptor of each group of a transaction spanning several vectors, in the order their vectors are updated.
+	// Shared by the whole transaction and each of its groups. NULL for a transaction on a single vector.
+	std::vector<Desc *> *groups = NULL;
+	// The vector a group runs on. NULL for anything but a group.
+	GroupVector *vector = NULL;
+#endif
 #ifdef SEGMENTVEC
 	// A list of pages for the transaction to insert.
-	std::atomic<std::map<size_t, Page<VAL, SGMT_SIZE> *, ORDER, MemAllocator<std::pair<size_t, Page<VAL, SGMT_SIZE> *>>> *> pages;
+	std::atomic<PageMap *> pages;
+#endif
+#ifdef WAIT_FREE
+	// When the transaction was announced. Lower tickets are older, and get helped first.
+	std::atomic<size_t> ticket;
 #endif
 #ifdef CONFLICT_FREE_READS
 	// Used to determine how to reorder conflict-free reads.
 	std::atomic<size_t> version;
 	// Used to identify whether or not the transaction is of the conflict-free variety.
+	// Set by the vector when the transaction is submitted. Callers don't need to set this.
 	bool isConflictFree = false;
 #endif
 #ifdef METRICS
@@ -123,14 +140,55 @@ struct Desc
 	// ops:     An array of operations, passed by reference.
 	// size:    The number of operations in the operations array.
 	Desc(unsigned int size, Operation *ops);
+	// Create a descriptor from a prepared plan.
+	// plan:    The compiled transaction shape. Must outlive the descriptor.
+	// ops:     An array of operations with indexes and values set. Types are filled in from the plan.
+	Desc(const TransactionPlan &plan, Operation *ops);
+#if defined(SEGMENTVEC) || defined(COMPACTVEC) || defined(BOOSTEDVEC)
+	// Create a descriptor for a transaction spanning several vectors.
+	// Every group commits or aborts together. Results go in each group's operations.
+	// groups:  The operations to run on each vector. Each vector may only have one group.
+	//          Otherwise, the descriptor starts out aborted, with an invalid cause.
+	explicit Desc(const std::vector<OpGroup> &groups);
+#endif
 	~Desc();
 
+	// Abort the transaction, recording why.
+	// Only the first cause sticks, since anything after it follows from the first abort.
+	// Does nothing to the status of a transaction that already committed.
+	void abort(AbortCause cause);
+#if defined(SEGMENTVEC) || defined(COMPACTVEC)
+	// Recycle the set and pages map of a finished transaction, or of each of its groups, once no helper can reach them.
+	// Helpers only reach these through an active transaction, so this is safe as soon as it finishes.
+	// The descriptor itself stays, since the vector keeps referencing it.
+	void retireSets();
+#endif
+#if defined(BOOSTEDVEC) || defined(STMVEC) || defined(COARSEVEC) || defined(STOVEC)
+	// Make a finished descriptor active again, so its operations can run once more without building another.
+	// Lock-based engines are done with a descriptor once it returns. The lock-free ones leave it referenced from the vector, so it can't be reset there.
+	void reset();
+#endif
+
 	// Used to get our final results after a transaction commits.
 	VAL *getResult(size_t index);
 
 	// Print out the contents of the vector at a given time.
 	// This function is not atomic unless the transaction has committed or aborted.
 	void print();
+
+private:
+#ifndef BOOSTEDVEC
+	// The status a descriptor refers to, unless it is a group of another one.
+	std::atomic<TxStatus> ownStatus;
+#endif
+	// The abort cause a descriptor refers to, unless it is a group of another one.
+	std::atomic<AbortCause> ownCause;
+#if defined(SEGMENTVEC) || defined(COMPACTVEC) || defined(BOOSTEDVEC)
+	// Create a group of a transaction spanning several vectors.
+	Desc(Desc *owner, const OpGroup &group);
+#endif
 };
 
+END_ENGINE_NAMESPACE
+
 #endif
\ No newline at end of file
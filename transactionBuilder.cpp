@@ -0,0 +1,38 @@
+#include <cstring>
+
+#include "transactionBuilder.hpp"
+
+TransactionBuilder::TransactionBuilder(Region &region, unsigned int capacity)
+{
+	this->region = &region;
+	this->capacity = capacity == 0 ? 1 : capacity;
+	ops = (Operation *)region.allocate(this->capacity * sizeof(Operation), alignof(Operation));
+	return;
+}
+
+Operation &TransactionBuilder::append(Operation::OpType type, size_t index, VAL val)
+{
+	if (count == capacity)
+	{
+		grow();
+	}
+	Operation &op = ops[count++];
+	op.type = type;
+	op.index = index;
+	op.val = val;
+	op.expected = UNSET;
+	op.ret = UNSET;
+	return op;
+}
+
+void TransactionBuilder::grow()
+{
+	// Fixed storage can't grow, so its size must cover every transaction built in it.
+	assert(region != NULL);
+	// The old array stays in the region until it is reset.
+	Operation *larger = (Operation *)region->allocate(capacity * 2 * sizeof(Operation), alignof(Operation));
+	memcpy(larger, ops, count * sizeof(Operation));
+	ops = larger;
+	capacity *= 2;
+	return;
+}
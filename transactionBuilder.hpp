@@ -0,0 +1,220 @@
+/*
+This file holds builders that assemble a transaction one operation at a time.
+Each operation that produces a result returns a handle to it, so callers never index into the operation array themselves.
+TransactionBuilder keeps its operations in a region, and FixedTransactionBuilder keeps them inline, so building a transaction never touches the heap.
+Submitting one only stays off the heap on the lock-based engines. See Engine::execute.
+*/
+#ifndef TRANSACTIONBUILDER_HPP
+#define TRANSACTIONBUILDER_HPP
+
+#include <assert.h>
+#include <cstddef>
+
+#include "define.hpp"
+#include "engine.hpp"
+#include "operation.hpp"
+#include "region.hpp"
+#include "retryPolicy.hpp"
+
+class TransactionBuilder;
+
+// The value returned by a read, a pop, or a compare write.
+// Only valid once the transaction has committed.
+class ValueResult
+{
+private:
+	const TransactionBuilder *builder;
+	unsigned int position;
+
+public:
+	ValueResult(const TransactionBuilder *builder, unsigned int position) : builder(builder), position(position) {}
+	VAL get() const;
+};
+
+// The value returned by a size operation, offset by the pushes and pops before it.
+// Only valid once the transaction has committed.
+class SizeResult
+{
+private:
+	const TransactionBuilder *builder;
+	unsigned int position;
+
+public:
+	SizeResult(const TransactionBuilder *builder, unsigned int position) : builder(builder), position(position) {}
+	size_t get() const;
+};
+
+class TransactionBuilder
+{
+	friend class ValueResult;
+	friend class SizeResult;
+
+private:
+	// The operations added so far.
+	Operation *ops;
+	unsigned int capacity;
+	unsigned int count = 0;
+	// The region more room is taken from once the operations fill up. NULL if the storage is fixed.
+	Region *region;
+
+	// Add an operation, making room for it if needed.
+	Operation &append(Operation::OpType type, size_t index, VAL val);
+	// Move the operations into a larger array from the region.
+	void grow();
+
+protected:
+	// Build into fixed storage, which must outlive the builder.
+	TransactionBuilder(Operation *storage, unsigned int capacity) : ops(storage), capacity(capacity), region(NULL) {}
+
+public:
+	// Build into a region. The operations, and the results read through handles, live until the region is reset.
+	// capacity:    The number of operations to make room for up front. The builder grows past it if needed.
+	explicit TransactionBuilder(Region &region, unsigned int capacity = 8);
+	// Handles point back into the builder, so it stays in place.
+	TransactionBuilder(const TransactionBuilder &) = delete;
+	TransactionBuilder &operator=(const TransactionBuilder &) = delete;
+
+	// Append a value past the end of the vector.
+	TransactionBuilder &pushBack(VAL val)
+	{
+		append(Operation::OpType::pushBack, 0, val);
+		return *this;
+	}
+	// Remove the last value of the vector.
+	ValueResult popBack()
+	{
+		append(Operation::OpType::popBack, 0, UNSET);
+		return ValueResult(this, count - 1);
+	}
+	// Insert a value in front of the first element of a deque.
+	TransactionBuilder &pushFront(VAL val)
+	{
+		append(Operation::OpType::pushFront, 0, val);
+		return *this;
+	}
+	// Remove the first value of a deque.
+	ValueResult popFront()
+	{
+		append(Operation::OpType::popFront, 0, UNSET);
+		return ValueResult(this, count - 1);
+	}
+	// Ensure room for at least size elements.
+	TransactionBuilder &reserve(size_t size)
+	{
+		append(Operation::OpType::reserve, size, UNSET);
+		return *this;
+	}
+	// Read the value at an index.
+	ValueResult read(size_t index)
+	{
+		append(Operation::OpType::read, index, UNSET);
+		return ValueResult(this, count - 1);
+	}
+	// Write a value at an index.
+	TransactionBuilder &write(size_t index, VAL val)
+	{
+		append(Operation::OpType::write, index, val);
+		return *this;
+	}
+	// Write a value at an index, only if the index holds the expected value.
+	// The handle gets the value found, so the write happened if it matches expected.
+	ValueResult compareWrite(size_t index, VAL expected, VAL val)
+	{
+		append(Operation::OpType::compareWrite, index, val).expected = expected;
+		return ValueResult(this, count - 1);
+	}
+	// Write a value at an index, aborting the whole transaction unless the index holds the expected value.
+	TransactionBuilder &compareWriteOrAbort(size_t index, VAL expected, VAL val)
+	{
+		append(Operation::OpType::compareWriteOrAbort, index, val).expected = expected;
+		return *this;
+	}
+	// Add to the value at an index.
+	// Like the other updates, it commutes with concurrent updates of the same kind and leaves unset elements alone.
+	TransactionBuilder &fetchAdd(size_t index, VAL val)
+	{
+		append(Operation::OpType::fetchAdd, index, val);
+		return *this;
+	}
+	// Lower the value at an index to at most val.
+	TransactionBuilder &fetchMin(size_t index, VAL val)
+	{
+		append(Operation::OpType::fetchMin, index, val);
+		return *this;
+	}
+	// Raise the value at an index to at least val.
+	TransactionBuilder &fetchMax(size_t index, VAL val)
+	{
+		append(Operation::OpType::fetchMax, index, val);
+		return *this;
+	}
+	// Exclusive or val into the value at an index.
+	TransactionBuilder &fetchXor(size_t index, VAL val)
+	{
+		append(Operation::OpType::fetchXor, index, val);
+		return *this;
+	}
+	// Read the size of the vector.
+	SizeResult size()
+	{
+		append(Operation::OpType::size, 0, UNSET);
+		return SizeResult(this, count - 1);
+	}
+
+	// Get the operations added so far, to build a descriptor from.
+	// A descriptor built from these must be done with them before the builder's storage goes away.
+	Operation *operations() const
+	{
+		return ops;
+	}
+	// Get the number of operations added so far.
+	unsigned int operationCount() const
+	{
+		return count;
+	}
+	// Drop every operation, so the builder can assemble another transaction in the same storage.
+	// Invalidates every handle taken so far.
+	void clear()
+	{
+		count = 0;
+	}
+
+	// Run the transaction on an engine.
+	// Returns true if it committed, and the handles can be read.
+	bool execute(Engine &engine)
+	{
+		return engine.execute(ops, count);
+	}
+	// Run the transaction on an engine, running it again after each abort the policy retries.
+	// cause:   If not NULL, gets why the last attempt aborted, or none if it committed.
+	// Returns true if some attempt committed, and the handles can be read.
+	bool execute(Engine &engine, const RetryPolicy &policy, AbortCause *cause = NULL)
+	{
+		return engine.execute(ops, count, policy, cause);
+	}
+};
+
+// A builder holding up to N operations inline, for transactions with a size known at compile time.
+// Keep it on the stack to build transactions without any allocation, and on the lock-based engines to submit them too.
+template <unsigned int N>
+class FixedTransactionBuilder : public TransactionBuilder
+{
+private:
+	Operation storage[N];
+
+public:
+	FixedTransactionBuilder() : TransactionBuilder(storage, N) {}
+};
+
+inline VAL ValueResult::get() const
+{
+	return builder->ops[position].ret;
+}
+
+inline size_t SizeResult::get() const
+{
+	// Size results go in index rather than ret, since they may not fit in a value.
+	return builder->ops[position].index;
+}
+
+#endif
@@ -0,0 +1,107 @@
+#include "transactionPlan.hpp"
+
+TransactionPlan::TransactionPlan(const Operation::OpType *types, unsigned int size)
+{
+	this->types.assign(types, types + size);
+	positions.assign(size, 0);
+	sources.assign(size, SIZE_MAX);
+
+	// Walk size through the transaction, relative to its starting value.
+	long current = 0;
+	long lowest = 0;
+	long highest = 0;
+	for (size_t i = 0; i < size; i++)
+	{
+		readOnly &= (types[i] == Operation::OpType::read);
+		switch (types[i])
+		{
+		case Operation::OpType::pushBack:
+			positions[i] = current++;
+			pushes++;
+			usesSize = true;
+			break;
+		case Operation::OpType::popBack:
+			positions[i] = --current;
+			pops++;
+			usesSize = true;
+			break;
+		case Operation::OpType::size:
+			positions[i] = current;
+			usesSize = true;
+			exclusiveSize = true;
+			break;
+		case Operation::OpType::read:
+		case Operation::OpType::write:
+		case Operation::OpType::compareWrite:
+		case Operation::OpType::compareWriteOrAbort:
+		case Operation::OpType::fetchAdd:
+		case Operation::OpType::fetchMin:
+		case Operation::OpType::fetchMax:
+		case Operation::OpType::fetchXor:
+			usesIndexes = true;
+			exclusiveSize = true;
+			break;
+		case Operation::OpType::pushFront:
+		case Operation::OpType::popFront:
+			usesSize = true;
+			usesFront = true;
+			exclusiveSize = true;
+			break;
+		case Operation::OpType::reserve:
+			break;
+		}
+		lowest = current < lowest ? current : lowest;
+		highest = current > highest ? current : highest;
+	}
+	popDepth = -lowest;
+	endPosition = current + popDepth;
+
+	// Shift every position up so that the lowest slot is 0.
+	// Positions were stored as the bits of a signed value, so unsigned wraparound makes this exact.
+	for (size_t i = 0; i < size; i++)
+	{
+		if (types[i] == Operation::OpType::pushBack || types[i] == Operation::OpType::popBack || types[i] == Operation::OpType::size)
+		{
+			positions[i] += popDepth;
+		}
+	}
+
+	// Resolve each slot. Size moves one slot at a time, so every slot in the range is touched.
+	slots.assign(highest - lowest, Slot());
+	std::vector<size_t> lastWriters(slots.size(), SIZE_MAX);
+	for (size_t i = 0; i < size; i++)
+	{
+		if (types[i] != Operation::OpType::pushBack && types[i] != Operation::OpType::popBack)
+		{
+			continue;
+		}
+		size_t slot = positions[i];
+		if (types[i] == Operation::OpType::popBack)
+		{
+			// Pop an earlier push directly, or read the old value if nothing was pushed here yet.
+			if (lastWriters[slot] != SIZE_MAX)
+			{
+				sources[i] = lastWriters[slot];
+			}
+			else
+			{
+				slots[slot].sharedReader = i;
+			}
+		}
+		lastWriters[slot] = i;
+	}
+	for (size_t i = 0; i < slots.size(); i++)
+	{
+		slots[i].lastWriter = lastWriters[i];
+	}
+	return;
+}
+
+void TransactionPlan::bind(Operation *ops) const
+{
+	for (size_t i = 0; i < types.size(); i++)
+	{
+		ops[i].type = types[i];
+	}
+	return;
+}
@@ -0,0 +1,68 @@
+/*
+This file holds prepared transaction plans.
+A plan compiles the shape of a transaction (its sequence of operation types) once.
+Descriptors built from a plan only bind indexes and values, and their read/write sets skip the per-operation analysis.
+*/
+#ifndef TRANSACTIONPLAN_HPP
+#define TRANSACTIONPLAN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "define.hpp"
+#include "operation.hpp"
+
+class TransactionPlan
+{
+public:
+	// A size-relative element location touched by push and pop operations.
+	// Every push and pop on it is already resolved against the others.
+	struct Slot
+	{
+		// The operation whose value is written here last.
+		size_t lastWriter;
+		// The pop that must read the old value from shared memory.
+		// SIZE_MAX if every pop here reads a value pushed earlier in the transaction.
+		size_t sharedReader = SIZE_MAX;
+	};
+
+	// The type of each operation, in order.
+	std::vector<Operation::OpType> types;
+	// Positions are relative to the lowest slot any pop reaches, which is the starting size minus popDepth.
+	// For push and pop, the slot touched. For size, the value reported.
+	std::vector<size_t> positions;
+	// For pops satisfied inside the transaction, the push they read from. SIZE_MAX otherwise.
+	std::vector<size_t> sources;
+	// The size-relative slots, starting at the lowest one.
+	std::vector<Slot> slots;
+	// How far below the starting size the pops reach.
+	size_t popDepth = 0;
+	// The final size, relative to the lowest slot.
+	size_t endPosition = 0;
+	// Set if any operation reads or changes size.
+	bool usesSize = false;
+	// Set if any operation reads or writes an absolute index.
+	bool usesIndexes = false;
+	// Counts used to pick a size lock mode without scanning the operations.
+	size_t pushes = 0;
+	size_t pops = 0;
+	// Set if the transaction does anything besides push, pop, and reserve.
+	bool exclusiveSize = false;
+	// Set if every operation is a read.
+	bool readOnly = true;
+	// Set if any operation works on the front of a deque.
+	// Those move the first element, so read/write sets analyze these transactions one operation at a time instead.
+	bool usesFront = false;
+
+	// Compile a plan.
+	// types:   The type of each operation, in order.
+	// size:    The number of operations.
+	TransactionPlan(const Operation::OpType *types, unsigned int size);
+
+	// Fill in the operation types of an operation array.
+	// The caller then only sets indexes and values before building a descriptor from it.
+	void bind(Operation *ops) const;
+};
+
+#endif
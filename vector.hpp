@@ -1,23 +1,37 @@
 #ifndef VECTOR_HPP
 #define VECTOR_HPP
 
+#include <algorithm>
 #include <cstdlib>
 #include <mutex>
 #include <ostream>
 
+#include "parallelFor.hpp"
 #include "transaction.hpp"
 
+BEGIN_ENGINE_NAMESPACE
+
 class Vector
 {
 private:
     size_t size = 0;
     size_t capacity = 0;
     VAL *array = NULL;
+    // The deque bound, a power of 2, or 0 if this isn't a deque.
+    // Elements of a deque start at head and wrap around the first ring slots of the array.
+    size_t ring = 0;
+    size_t head = 0;
+
+    // Find where the element at an index is stored.
+    size_t slot(size_t index)
+    {
+        return ring == 0 ? index : (head + index) & (ring - 1);
+    }
 
     size_t highestBit(size_t val)
     {
         // Subtract 1 so the rightmost position is 0 instead of 1.
-        return (sizeof(val) * 8) - __builtin_clz(val | 1) - 1;
+        return (sizeof(val) * 8) - __builtin_clzl(val | 1) - 1;
 
         // Slower alternate approach.
         size_t onePos = 0;
@@ -46,8 +60,49 @@ public:
         reserve(capacity);
         return;
     }
+    // Turn an empty vector into a deque of up to ring elements.
+    void makeRing(size_t ring)
+    {
+        // Round up to a power of 2, so positions wrap with a mask.
+        size_t bound = 1;
+        while (bound < ring)
+        {
+            bound <<= 1;
+        }
+        reserve(bound);
+        this->ring = bound;
+        head = 0;
+        return;
+    }
+    bool isDeque()
+    {
+        return ring != 0;
+    }
+    // Fill an empty vector, copying each thread's share of the values at once.
+    bool load(const VAL *values, size_t count, unsigned int threads)
+    {
+        if (size != 0 || (ring != 0 && count > ring) || !reserve(count))
+        {
+            return false;
+        }
+        parallelFor(count, 1024, threads, [&](size_t begin, size_t end) {
+            std::copy(values + begin, values + end, array + begin);
+        });
+        head = 0;
+        size = count;
+        return true;
+    }
     bool pushBack(VAL val)
     {
+        if (ring != 0)
+        {
+            if (size == ring)
+            {
+                return false;
+            }
+            array[slot(size++)] = val;
+            return true;
+        }
         if (size + 1 > capacity)
         {
             if (!reserve(size + 1))
@@ -64,7 +119,29 @@ public:
         {
             return false;
         }
-        val = array[--size];
+        val = array[slot(--size)];
+        return true;
+    }
+    bool pushFront(VAL val)
+    {
+        if (ring == 0 || size == ring)
+        {
+            return false;
+        }
+        head = (head - 1) & (ring - 1);
+        array[head] = val;
+        size++;
+        return true;
+    }
+    bool popFront(VAL &val)
+    {
+        if (ring == 0 || size == 0)
+        {
+            return false;
+        }
+        val = array[head];
+        head = (head + 1) & (ring - 1);
+        size--;
         return true;
     }
     bool read(size_t index, VAL &val)
@@ -73,7 +150,7 @@ public:
         {
             return false;
         }
-        val = array[index];
+        val = array[slot(index)];
         return true;
     }
     bool write(size_t index, VAL val)
@@ -82,7 +159,7 @@ public:
         {
             return false;
         }
-        array[index] = val;
+        array[slot(index)] = val;
         return true;
     }
     size_t getSize()
@@ -96,8 +173,13 @@ public:
         {
             return true;
         }
+        // A deque is bounded, and moving it would break its wrapped layout.
+        if (ring != 0)
+        {
+            return false;
+        }
         // Compute the smallest power of 2 >= to the requested capacity.
-        size_t reserveCapacity = 1 << (highestBit(capacity) + 1);
+        size_t reserveCapacity = (size_t)1 << (highestBit(capacity) + 1);
         // Allocate an array with a sufficient capacity.
         VAL *newArray = (VAL *)malloc(reserveCapacity * sizeof(VAL));
         // If we failed to allocate, then this reserve call fails.
@@ -140,6 +222,20 @@ private:
     std::mutex mtx;
 
 public:
+    // ring:    If not 0, the vector is a deque bounded to ring elements, rounded up to a power of 2.
+    explicit CoarseTransVector(size_t ring = 0)
+    {
+        if (ring != 0)
+        {
+            vector.makeRing(ring);
+        }
+    }
+    // Fill an empty vector without running transactions.
+    // Only valid before any transaction runs, and before any other thread has the vector.
+    bool bulkLoad(const VAL *values, size_t count, unsigned int threads)
+    {
+        return vector.load(values, count, threads);
+    }
     void executeTransaction(Desc *desc)
     {
 #ifdef METRICS
@@ -148,6 +244,8 @@ public:
         desc->preprocessTime = desc->startTime;
 #endif
         bool ret = true;
+        // Every failure but a compare or an unknown operation comes from reaching past the elements.
+        AbortCause cause = AbortCause::outOfBounds;
         mtx.lock();
         //printf("%lu got lock.\n", std::hash<std::thread::id>()(std::this_thread::get_id()));
         for (size_t i = 0; i < desc->size; i++)
@@ -167,13 +265,75 @@ public:
             case Operation::OpType::popBack:
                 ret = vector.popBack(op->ret);
                 break;
+            case Operation::OpType::pushFront:
+            case Operation::OpType::popFront:
+                // Only a deque has a front.
+                if (!vector.isDeque())
+                {
+                    cause = AbortCause::invalid;
+                    ret = false;
+                }
+                else if (op->type == Operation::OpType::pushFront)
+                {
+                    ret = vector.pushFront(op->val);
+                }
+                else
+                {
+                    ret = vector.popFront(op->ret);
+                }
+                break;
             case Operation::OpType::size:
-                op->ret = vector.getSize();
+                // Size results go in index, same as in the other vectors.
+                op->index = op->ret = vector.getSize();
                 break;
             case Operation::OpType::reserve:
                 ret = vector.reserve(op->index);
                 break;
+            case Operation::OpType::compareWrite:
+            case Operation::OpType::compareWriteOrAbort:
+                // Report the value found, and only write over the expected one.
+                ret = vector.read(op->index, op->ret);
+                if (ret && op->ret == op->expected)
+                {
+                    ret = vector.write(op->index, op->val);
+                }
+                else if (ret && op->type == Operation::OpType::compareWriteOrAbort)
+                {
+                    cause = AbortCause::compareFailed;
+                    ret = false;
+                }
+                break;
+            case Operation::OpType::fetchAdd:
+            case Operation::OpType::fetchMin:
+            case Operation::OpType::fetchMax:
+            case Operation::OpType::fetchXor:
+            {
+                // Updates leave elements without a value alone.
+                // They abort rather than store UNSET, which would read as an unset element that size still counts.
+                VAL current = UNSET;
+                VAL result = UNSET;
+                if (op->val == UNSET)
+                {
+                    cause = AbortCause::invalid;
+                    ret = false;
+                }
+                else if (vector.read(op->index, current) && current != UNSET)
+                {
+                    result = Operation::applyDelta(op->type, current, op->val);
+                    if (result == UNSET)
+                    {
+                        cause = AbortCause::invalid;
+                        ret = false;
+                    }
+                    else
+                    {
+                        ret = vector.write(op->index, result);
+                    }
+                }
+                break;
+            }
             default:
+                cause = AbortCause::invalid;
                 ret = false;
                 break;
             }
@@ -189,7 +349,7 @@ public:
         }
         else
         {
-            desc->status.store(Desc::TxStatus::aborted);
+            desc->abort(cause);
         }
         //printf("%lu releasing lock.\n", std::hash<std::thread::id>()(std::this_thread::get_id()));
         mtx.unlock();
@@ -212,6 +372,20 @@ private:
     Vector vector;
 
 public:
+    // ring:    If not 0, the vector is a deque bounded to ring elements, rounded up to a power of 2.
+    explicit GCCSTMVector(size_t ring = 0)
+    {
+        if (ring != 0)
+        {
+            vector.makeRing(ring);
+        }
+    }
+    // Fill an empty vector without running transactions.
+    // Only valid before any transaction runs, and before any other thread has the vector.
+    bool bulkLoad(const VAL *values, size_t count, unsigned int threads)
+    {
+        return vector.load(values, count, threads);
+    }
     void executeTransaction(Desc *desc)
     {
 #ifdef METRICS
@@ -220,6 +394,8 @@ public:
         desc->preprocessTime = desc->startTime;
 #endif
         bool ret = true;
+        // Every failure but a compare or an unknown operation comes from reaching past the elements.
+        AbortCause cause = AbortCause::outOfBounds;
         __transaction_atomic
         {
             for (size_t i = 0; i < desc->size; i++)
@@ -239,13 +415,75 @@ public:
                 case Operation::OpType::popBack:
                     ret = vector.popBack(op->ret);
                     break;
+                case Operation::OpType::pushFront:
+                case Operation::OpType::popFront:
+                    // Only a deque has a front.
+                    if (!vector.isDeque())
+                    {
+                        cause = AbortCause::invalid;
+                        ret = false;
+                    }
+                    else if (op->type == Operation::OpType::pushFront)
+                    {
+                        ret = vector.pushFront(op->val);
+                    }
+                    else
+                    {
+                        ret = vector.popFront(op->ret);
+                    }
+                    break;
                 case Operation::OpType::size:
-                    op->ret = vector.getSize();
+                    // Size results go in index, same as in the other vectors.
+                    op->index = op->ret = vector.getSize();
                     break;
                 case Operation::OpType::reserve:
                     ret = vector.reserve(op->index);
                     break;
+                case Operation::OpType::compareWrite:
+                case Operation::OpType::compareWriteOrAbort:
+                    // Report the value found, and only write over the expected one.
+                    ret = vector.read(op->index, op->ret);
+                    if (ret && op->ret == op->expected)
+                    {
+                        ret = vector.write(op->index, op->val);
+                    }
+                    else if (ret && op->type == Operation::OpType::compareWriteOrAbort)
+                    {
+                        cause = AbortCause::compareFailed;
+                        ret = false;
+                    }
+                    break;
+                case Operation::OpType::fetchAdd:
+                case Operation::OpType::fetchMin:
+                case Operation::OpType::fetchMax:
+                case Operation::OpType::fetchXor:
+                {
+                    // Updates leave elements without a value alone.
+                    // They abort rather than store UNSET, which would read as an unset element that size still counts.
+                    VAL current = UNSET;
+                    VAL result = UNSET;
+                    if (op->val == UNSET)
+                    {
+                        cause = AbortCause::invalid;
+                        ret = false;
+                    }
+                    else if (vector.read(op->index, current) && current != UNSET)
+                    {
+                        result = Operation::applyDelta(op->type, current, op->val);
+                        if (result == UNSET)
+                        {
+                            cause = AbortCause::invalid;
+                            ret = false;
+                        }
+                        else
+                        {
+                            ret = vector.write(op->index, result);
+                        }
+                    }
+                    break;
+                }
                 default:
+                    cause = AbortCause::invalid;
                     ret = false;
                     break;
                 }
@@ -262,7 +500,7 @@ public:
         }
         else
         {
-            desc->status.store(Desc::TxStatus::aborted);
+            desc->abort(cause);
         }
 #ifdef METRICS
         desc->endTime = std::chrono::high_resolution_clock::now();
@@ -278,4 +516,6 @@ public:
     }
 };
 
+END_ENGINE_NAMESPACE
+
 #endif
\ No newline at end of file